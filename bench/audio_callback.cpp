@@ -0,0 +1,161 @@
+#include <atomic>
+#include <memory>
+#include <random>
+#include <thread>
+
+#include "bench_common.hpp"
+#include "lfmq/channel.hpp"
+#include "lfmq/command_processor.hpp"
+
+namespace lfmq::bench
+{
+namespace
+{
+constexpr uint64_t SAMPLE_RATE = 48'000;
+constexpr size_t   QUEUE_SIZE  = 1024;
+
+/// Fraction of the callback period the consumer may spend draining messages
+constexpr double DRAIN_BUDGET = 0.1;
+
+struct Stamp {
+	uint64_t push_ns;
+	uint64_t sequence;
+};
+
+/*
+ * Receives every VOLUME message the callback dispatches
+ */
+struct AgeRecorder {
+	std::vector<uint64_t>* age_samples;
+	uint64_t*              messages;
+
+	static void on_volume(void* const context, const Message& message) {
+		AgeRecorder& recorder = *static_cast<AgeRecorder*>(context);
+
+		if (recorder.age_samples->size() < recorder.age_samples->capacity()) {
+			recorder.age_samples->push_back(now_ns() - message.get_payload<Stamp>().push_ns);
+		}
+		(*recorder.messages)++;
+	}
+};
+
+/*
+ * Models how SpscQueue<Message, N> is used by an audio engine: the consumer
+ * wakes once per callback period and lets a CommandProcessor drain the queue
+ * until it is either empty or out of budget, while the controller produces
+ * bursts of messages at random intervals. Every message carries the time it
+ * was pushed so that its age can be measured when the callback dequeues it.
+ */
+void run_one(const Options& options, const uint64_t period_frames) {
+	using clock = std::chrono::steady_clock;
+
+	const auto     period    = std::chrono::nanoseconds(period_frames * 1'000'000'000 / SAMPLE_RATE);
+	const uint64_t budget_ns = static_cast<uint64_t>(static_cast<double>(period.count()) * DRAIN_BUDGET);
+	const auto     duration  = std::chrono::milliseconds(options.duration_ms);
+
+	// only the controller to audio direction carries messages in this scenario
+	auto              channel  = Channel<Message, Message, QUEUE_SIZE>::create();
+	auto              to_audio = channel->controller().to_audio;
+	std::atomic<bool> running  = true;
+
+	std::vector<uint64_t> drain_samples;
+	std::vector<uint64_t> age_samples;
+	uint64_t              callbacks       = 0;
+	uint64_t              overruns        = 0;
+	uint64_t              budget_exceeded = 0;
+	uint64_t              messages        = 0;
+
+	// the budget is in steady clock ticks so that it is measured like every other time in the scenario
+	CommandProcessor<1, SteadyClock> processor;
+	AgeRecorder                      recorder{ &age_samples, &messages };
+
+	processor.add_queue(channel->audio().from_controller);
+	processor.set_handler(MessageType::VOLUME, AgeRecorder::on_volume, &recorder);
+	processor.set_budget(CommandBudget{ SIZE_MAX, budget_ns });
+
+	std::thread audio([&] {
+		pin_this_thread(options.consumer_cpu);
+
+		// reserved up front so that recording samples never allocates inside a callback
+		drain_samples.reserve(static_cast<size_t>(duration / period) + 1);
+		age_samples.reserve(drain_samples.capacity() * options.burst_max);
+
+		const clock::time_point end      = clock::now() + duration;
+		clock::time_point       deadline = clock::now() + period;
+
+		while (deadline < end) {
+			std::this_thread::sleep_until(deadline);
+
+			const ProcessResult drained = processor.process();
+			drain_samples.push_back(drained.ticks);
+			callbacks++;
+
+			if (drained.exhausted) {
+				budget_exceeded++;
+			}
+
+			deadline += period;
+			// the callback woke up after the next one was already due
+			if (clock::now() > deadline) {
+				overruns++;
+			}
+		}
+
+		running.store(false);
+	});
+
+	uint64_t full_events = 0;
+	uint64_t sent        = 0;
+
+	std::thread controller([&] {
+		pin_this_thread(options.producer_cpu);
+
+		std::mt19937_64                         rng(period_frames);
+		std::uniform_int_distribution<uint64_t> gap_ns(0, 2 * static_cast<uint64_t>(period.count()));
+		std::uniform_int_distribution<size_t>   burst(1, options.burst_max);
+
+		while (running.load()) {
+			std::this_thread::sleep_for(std::chrono::nanoseconds(gap_ns(rng)));
+
+			const size_t count = burst(rng);
+			for (size_t i = 0; i < count && running.load(); i++) {
+				const Message message(MessageMetadata(MessageType::VOLUME), Stamp{ now_ns(), sent });
+
+				// a full queue is reported and the message retried, as a controller would
+				while (!to_audio.push(message) && running.load()) {
+					full_events++;
+					std::this_thread::sleep_for(period / 4);
+				}
+
+				sent++;
+			}
+		}
+	});
+
+	audio.join();
+	controller.join();
+
+	Result result("audio_callback");
+	result.add("period_frames", period_frames)
+		.add("sample_rate", SAMPLE_RATE)
+		.add("budget_ns", budget_ns)
+		.add("burst_max", static_cast<uint64_t>(options.burst_max))
+		.add("callbacks", callbacks)
+		.add("messages", messages)
+		.add("queue_full_events", full_events)
+		.add("budget_exceeded", budget_exceeded)
+		.add("overruns", overruns);
+	Percentiles::of(drain_samples).add_to(result, "drain_ns");
+	Percentiles::of(age_samples).add_to(result, "age_ns");
+	result.print();
+}
+} // namespace
+
+bool run_audio_callback(const Options& options) {
+	for (const uint64_t period_frames : { 64, 128, 256 }) {
+		run_one(options, period_frames);
+	}
+
+	return true;
+}
+} // namespace lfmq::bench
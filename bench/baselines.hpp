@@ -0,0 +1,172 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+#include "bench_common.hpp"
+#include "lfmq/lock_free_queue.hpp"
+#include "lfmq/ring_storage.hpp"
+
+namespace lfmq::bench
+{
+/*
+ * Reference queues the benchmarks run next to SpscQueue, so that every
+ * result comes with a point of comparison measured on the same machine in
+ * the same run. They share the push/pop interface of SpscQueue and, like it,
+ * hold at most _size - 1 elements.
+ */
+
+/*
+ * Bounded queue guarded by a mutex, the obvious way to pass elements between
+ * two threads
+ */
+template <typename _T, size_t _size>
+class MutexDequeQueue {
+public:
+	bool push(const _T& element) {
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		if (this->elements.size() == _size - 1) {
+			return false;
+		}
+
+		this->elements.push_back(element);
+
+		return true;
+	}
+
+	bool pop(_T* const element = nullptr) {
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		if (this->elements.empty()) {
+			return false;
+		}
+
+		if (element != nullptr) {
+			*element = std::move(this->elements.front());
+		}
+
+		this->elements.pop_front();
+
+		return true;
+	}
+
+private:
+	std::mutex     mutex;
+	std::deque<_T> elements;
+};
+
+/*
+ * Ring buffer with the layout and algorithm of SpscQueue, both indices side
+ * by side just like there, but every index access is a sequentially
+ * consistent load or store instead of acquire/release, and indices wrap with
+ * a modulo. Comparing it to SpscQueue measures the cost of the memory
+ * ordering, not of cache line padding.
+ */
+template <typename _T, size_t _size>
+class SeqCstRing {
+public:
+	bool push(const _T& element) {
+		const size_t curr_write_index = this->write_index.load();
+		const size_t next_index       = (curr_write_index + 1) % _size;
+
+		if (next_index == this->read_index.load()) {
+			return false;
+		}
+
+		this->elements[curr_write_index] = element;
+		this->write_index.store(next_index);
+
+		return true;
+	}
+
+	bool pop(_T* const element = nullptr) {
+		const size_t curr_read_index = this->read_index.load();
+
+		if (curr_read_index == this->write_index.load()) {
+			return false;
+		}
+
+		if (element != nullptr) {
+			*element = this->elements[curr_read_index];
+		}
+
+		this->read_index.store((curr_read_index + 1) % _size);
+
+		return true;
+	}
+
+private:
+	_T elements[_size];
+
+	std::atomic<size_t> read_index  = 0;
+	std::atomic<size_t> write_index = 0;
+};
+
+/*
+ * Queue implementations swept by the benchmarks. Each one names a queue
+ * template instantiated with the element type and capacity of a run.
+ */
+struct LfmqQueueKind {
+	template <typename _T, size_t _size>
+	using type = SpscQueue<_T, _size>;
+
+	static constexpr const char* name = "lfmq";
+};
+
+struct MappedQueueTraits : DefaultQueueTraits {
+	using storage_policy = MappedStorage;
+};
+
+struct MappedQueueKind {
+	template <typename _T, size_t _size>
+	using type = SpscQueue<_T, _size, MappedQueueTraits>;
+
+	static constexpr const char* name = "lfmq_mapped";
+};
+
+struct MutexDequeKind {
+	template <typename _T, size_t _size>
+	using type = MutexDequeQueue<_T, _size>;
+
+	static constexpr const char* name = "mutex_deque";
+};
+
+struct SeqCstRingKind {
+	template <typename _T, size_t _size>
+	using type = SeqCstRing<_T, _size>;
+
+	static constexpr const char* name = "seq_cst_ring";
+};
+
+/**
+ * @brief Call fn.template operator()<QueueKind>() for SpscQueue, for SpscQueue on MappedStorage if options.mapped_storage is set and, unless options.baselines is false, for every baseline
+ */
+template<typename _F>
+void for_each_queue(const Options& options, _F&& fn) {
+	fn.template operator()<LfmqQueueKind>();
+
+	if (options.mapped_storage) {
+		fn.template operator()<MappedQueueKind>();
+	}
+
+	if (options.baselines) {
+		fn.template operator()<MutexDequeKind>();
+		fn.template operator()<SeqCstRingKind>();
+	}
+}
+
+/**
+ * @brief Add where the ring of queue lives to result, if the queue uses MappedStorage
+ */
+template<typename _Queue>
+void add_storage_to(Result& result, const _Queue& queue) {
+	if constexpr (requires { queue.storage().pages(); }) {
+		result.add("ring_pages", ring_pages_name(queue.storage().pages()))
+			.add("ring_locked", queue.storage().is_locked() ? "true" : "false")
+			.add("ring_mapped_bytes", static_cast<uint64_t>(queue.storage().mapped_bytes()));
+	}
+}
+} // namespace lfmq::bench
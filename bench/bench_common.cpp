@@ -0,0 +1,49 @@
+#include "bench_common.hpp"
+
+namespace lfmq::bench
+{
+/*
+ * Start Percentiles struct definitions
+ */
+Percentiles Percentiles::of(std::vector<uint64_t>& samples) {
+	Percentiles percentiles;
+
+	if (samples.empty()) {
+		return percentiles;
+	}
+
+	std::sort(samples.begin(), samples.end());
+
+	const auto at = [&](const double quantile) {
+		return samples[static_cast<size_t>(quantile * static_cast<double>(samples.size() - 1))];
+	};
+
+	double sum = 0;
+	for (const uint64_t sample : samples) {
+		sum += static_cast<double>(sample);
+	}
+
+	percentiles.min  = samples.front();
+	percentiles.p50  = at(0.5);
+	percentiles.p90  = at(0.9);
+	percentiles.p99  = at(0.99);
+	percentiles.p999 = at(0.999);
+	percentiles.max  = samples.back();
+	percentiles.mean = sum / static_cast<double>(samples.size());
+
+	return percentiles;
+}
+
+void Percentiles::add_to(Result& result, const std::string& prefix) const {
+	result.add((prefix + "_min").c_str(), this->min)
+		.add((prefix + "_p50").c_str(), this->p50)
+		.add((prefix + "_p90").c_str(), this->p90)
+		.add((prefix + "_p99").c_str(), this->p99)
+		.add((prefix + "_p999").c_str(), this->p999)
+		.add((prefix + "_max").c_str(), this->max)
+		.add((prefix + "_mean").c_str(), this->mean);
+}
+/*
+ * End Percentiles struct definitions
+ */
+} // namespace lfmq::bench
@@ -0,0 +1,311 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "lfmq/message.hpp"
+#include "lfmq/thread_placement.hpp"
+
+namespace lfmq::bench
+{
+/*
+ * Options shared by every scenario, parsed from the command line in main.cpp
+ */
+struct Options {
+	size_t   messages         = 1'000'000; // Messages sent per throughput run
+	size_t   round_trips      = 100'000;   // Round trips per latency run
+	int      producer_cpu     = -1;        // CPU the producer is pinned to, -1 to leave it unpinned
+	int      consumer_cpu     = -1;        // CPU the consumer is pinned to, -1 to leave it unpinned
+	size_t   duration_ms      = 2'000;     // Length of every timed simulation
+	size_t   burst_max        = 64;        // Largest burst of messages sent by the simulated controller
+	bool     perf_counters    = true;      // Read hardware performance counters around every run
+	size_t   iterations       = 100;       // Randomized runs of the stress scenario
+	size_t   stress_messages  = 20'000;    // Messages sent per stress run
+	size_t   stress_iteration = SIZE_MAX;  // Only run this stress iteration of --seed, SIZE_MAX to run them all
+	uint64_t seed             = 1;         // Seed of every randomized scenario
+	bool     baselines        = true;      // Also run the baseline queues of baselines.hpp
+	bool     mapped_storage   = false;     // Also run SpscQueue with its ring on MappedStorage
+	int      rt_priority      = 0;         // SCHED_FIFO priority of the latency scenarios' threads, 0 to leave them on the policy they inherit
+};
+
+/*
+ * Builds one flat JSON object per result and prints it on its own line, so
+ * the output can be consumed with any JSON lines tool
+ */
+class Result {
+public:
+	explicit Result(const char* const scenario) {
+		this->add("scenario", scenario);
+	}
+
+	Result& add(const char* const key, const char* const value) {
+		this->begin_field(key);
+		this->json += '"';
+		this->json += value;
+		this->json += '"';
+		return *this;
+	}
+
+	Result& add(const char* const key, const std::string& value) {
+		return this->add(key, value.c_str());
+	}
+
+	Result& add(const char* const key, const uint64_t value) {
+		this->begin_field(key);
+		this->json += std::to_string(value);
+		return *this;
+	}
+
+	Result& add(const char* const key, const int value) {
+		this->begin_field(key);
+		this->json += std::to_string(value);
+		return *this;
+	}
+
+	Result& add(const char* const key, const double value) {
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), "%.3f", value);
+
+		this->begin_field(key);
+		this->json += buffer;
+		return *this;
+	}
+
+	void print() const {
+		printf("{%s}\n", this->json.c_str());
+		fflush(stdout);
+
+		if (copy != nullptr) {
+			fprintf(copy, "{%s}\n", this->json.c_str());
+			fflush(copy);
+		}
+	}
+
+	/**
+	 * @brief Also write every printed result to file
+	 * @param file File results are copied to, nullptr to stop copying
+	 */
+	static void copy_to(FILE* const file) noexcept {
+		copy = file;
+	}
+
+private:
+	void begin_field(const char* const key) {
+		if (!this->json.empty()) {
+			this->json += ',';
+		}
+
+		this->json += '"';
+		this->json += key;
+		this->json += "\":";
+	}
+
+	std::string json;
+
+	static inline FILE* copy = nullptr;
+};
+
+/**
+ * @brief Return a monotonic timestamp in nanoseconds
+ * @return Monotonic timestamp in nanoseconds
+ */
+inline uint64_t now_ns() noexcept {
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * @brief Switch the calling thread to SCHED_FIFO if --rt-priority was given, otherwise leave its inherited policy alone
+ * @return False if SCHED_FIFO was asked for and could not be applied
+ */
+inline bool apply_rt_priority(const Options& options) {
+	return options.rt_priority <= 0 || set_realtime_priority(options.rt_priority);
+}
+
+/*
+ * Spin-wait helper. Spins with a pause hint for a short while and then
+ * yields, so that the benchmarks stay meaningful when both sides of a queue
+ * share a core.
+ */
+class Backoff {
+public:
+	void pause() noexcept {
+		if (this->spins < SPIN_LIMIT) {
+			this->spins++;
+#if defined(__x86_64__) || defined(__i386__)
+			_mm_pause();
+#endif
+		} else {
+			std::this_thread::yield();
+		}
+	}
+
+	void reset() noexcept {
+		this->spins = 0;
+	}
+
+private:
+	static constexpr unsigned SPIN_LIMIT = 1024;
+
+	unsigned spins = 0;
+};
+
+/*
+ * Summary of a set of samples
+ */
+struct Percentiles {
+	uint64_t min  = 0;
+	uint64_t p50  = 0;
+	uint64_t p90  = 0;
+	uint64_t p99  = 0;
+	uint64_t p999 = 0;
+	uint64_t max  = 0;
+	double   mean = 0;
+
+	/**
+	 * @brief Compute the summary of samples
+	 * @param samples Samples to summarize. Sorted in place
+	 * @return Summary of samples
+	 */
+	static Percentiles of(std::vector<uint64_t>& samples);
+
+	/**
+	 * @brief Add the summary to result with every key prefixed by prefix
+	 */
+	void add_to(Result& result, const std::string& prefix) const;
+};
+
+/*
+ * Plain element of a fixed size, used to sweep the element size independently of Message
+ */
+template <size_t _size>
+struct Blob {
+	std::array<uint8_t, _size> bytes{};
+};
+
+/**
+ * @brief Build the message that is sent by the benchmarks, with a payload of _payload_size bytes
+ * @param sequence Value stored at the start of the payload
+ * @return Message with a payload of _payload_size bytes
+ */
+template<size_t _payload_size> requires (_payload_size >= sizeof(uint64_t))
+Message make_message(const uint64_t sequence) {
+	std::array<uint8_t, _payload_size> payload{};
+	memcpy(payload.data(), &sequence, sizeof(sequence));
+
+	return Message(MessageMetadata(MessageType::VOLUME), payload);
+}
+
+/*
+ * Element kinds swept by the benchmarks. Each one names an element type,
+ * how to build one carrying a sequence number and how to read it back.
+ */
+struct U64Kind {
+	using type = uint64_t;
+
+	static constexpr const char* name         = "uint64";
+	static constexpr size_t      payload_size = sizeof(uint64_t);
+
+	static type make(const uint64_t sequence) noexcept {
+		return sequence;
+	}
+
+	static uint64_t sequence(const type& element) noexcept {
+		return element;
+	}
+};
+
+template <size_t _size> requires (_size >= sizeof(uint64_t))
+struct BlobKind {
+	using type = Blob<_size>;
+
+	static constexpr const char* name         = "blob";
+	static constexpr size_t      payload_size = _size;
+
+	static type make(const uint64_t sequence) noexcept {
+		type element;
+		memcpy(element.bytes.data(), &sequence, sizeof(sequence));
+		return element;
+	}
+
+	static uint64_t sequence(const type& element) noexcept {
+		uint64_t sequence;
+		memcpy(&sequence, element.bytes.data(), sizeof(sequence));
+		return sequence;
+	}
+};
+
+template <size_t _payload_size>
+struct MessageKind {
+	using type = Message;
+
+	static constexpr const char* name         = "Message";
+	static constexpr size_t      payload_size = _payload_size;
+
+	static type make(const uint64_t sequence) {
+		return make_message<_payload_size>(sequence);
+	}
+
+	static uint64_t sequence(const type& element) noexcept {
+		uint64_t sequence;
+		memcpy(&sequence, element.get_payload(), sizeof(sequence));
+		return sequence;
+	}
+};
+
+/**
+ * @brief Call fn.template operator()<Kind, capacity>() for every swept element kind and queue capacity
+ */
+template<typename _F>
+void for_each_config(_F&& fn) {
+	const auto for_each_capacity = [&]<typename _Kind>() {
+		fn.template operator()<_Kind, 64>();
+		fn.template operator()<_Kind, 1024>();
+		fn.template operator()<_Kind, 16384>();
+	};
+
+	for_each_capacity.template operator()<U64Kind>();
+	for_each_capacity.template operator()<BlobKind<64>>();
+	for_each_capacity.template operator()<MessageKind<8>>();
+	for_each_capacity.template operator()<MessageKind<64>>();
+	for_each_capacity.template operator()<MessageKind<Message::MAX_MESSAGE_SIZE>>();
+}
+
+/*
+ * Entry of the scenario table in main.cpp
+ */
+struct Scenario {
+	const char* name;
+	const char* description;
+	bool (*run)(const Options& options); // Returns false if the scenario detected an error
+	bool        run_by_default;          // Whether the scenario runs when none are named on the command line
+};
+
+bool run_throughput(const Options& options);
+bool run_ping_pong(const Options& options);
+bool run_audio_callback(const Options& options);
+bool run_stress(const Options& options);
+bool run_model(const Options& options);
+bool run_matrix(const Options& options);
+bool run_logger(const Options& options);
+bool run_notifier(const Options& options);
+
+/**
+ * @brief Compare the results in current against the ones in baseline and print a line for every metric
+ * @param baseline_path JSON lines file written by an earlier run with --output
+ * @param current_path JSON lines file of the run being checked
+ * @param threshold_pct Change in percent a metric has to get worse by to count as a regression
+ * @return Whether both files could be read and no metric regressed
+ */
+bool compare_results(const char* baseline_path, const char* current_path, double threshold_pct);
+} // namespace lfmq::bench
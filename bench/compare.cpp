@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "bench_common.hpp"
+
+namespace lfmq::bench
+{
+namespace
+{
+/*
+ * Metric compared between runs, and which way is better
+ */
+struct Metric {
+	const char* scenario;
+	const char* key;
+	bool        higher_is_better;
+};
+
+constexpr Metric METRICS[] = {
+	{ "throughput",     "msgs_per_sec",             true  },
+	{ "throughput",     "perf_instructions_per_op", false },
+	{ "ping_pong",      "rtt_ns_p50",               false },
+	{ "ping_pong",      "rtt_ns_p99",               false },
+	{ "ping_pong",      "perf_instructions_per_op", false },
+	{ "audio_callback", "drain_ns_p99",             false },
+};
+
+/// Fields that identify which configuration a result was measured with
+constexpr const char* IDENTITY_KEYS[] = {
+	"queue",
+	"element",
+	"element_size",
+	"payload_size",
+	"capacity",
+	"period_frames",
+	"burst_max",
+};
+
+/// Result line as field name to raw JSON value, with the quotes of strings removed
+using Record = std::map<std::string, std::string>;
+
+/**
+ * @brief Parse one flat JSON object as written by Result
+ * @return Whether the line was a flat JSON object
+ */
+bool parse_record(const std::string& line, Record& record) {
+	size_t i = line.find('{');
+	if (i == std::string::npos) {
+		return false;
+	}
+	i++;
+
+	while (i < line.size() && line[i] != '}') {
+		if (line[i] == ',' || line[i] == ' ') {
+			i++;
+			continue;
+		}
+
+		if (line[i] != '"') {
+			return false;
+		}
+
+		const size_t key_end = line.find('"', i + 1);
+		if (key_end == std::string::npos || key_end + 1 >= line.size() || line[key_end + 1] != ':') {
+			return false;
+		}
+
+		const std::string key = line.substr(i + 1, key_end - i - 1);
+		i = key_end + 2;
+
+		if (i < line.size() && line[i] == '"') {
+			const size_t value_end = line.find('"', i + 1);
+			if (value_end == std::string::npos) {
+				return false;
+			}
+
+			record[key] = line.substr(i + 1, value_end - i - 1);
+			i = value_end + 1;
+		} else {
+			const size_t value_end = line.find_first_of(",}", i);
+			if (value_end == std::string::npos) {
+				return false;
+			}
+
+			record[key] = line.substr(i, value_end - i);
+			i = value_end;
+		}
+	}
+
+	return i < line.size();
+}
+
+/**
+ * @brief Build the name a result is matched across runs by, such as throughput/queue=lfmq/element=uint64/capacity=64
+ */
+std::string benchmark_name(const Record& record) {
+	std::string name = record.at("scenario");
+
+	for (const char* const key : IDENTITY_KEYS) {
+		if (const auto it = record.find(key); it != record.end()) {
+			name += '/';
+			name += key;
+			name += '=';
+			name += it->second;
+		}
+	}
+
+	return name;
+}
+
+/*
+ * Every value of every compared metric in a results file, by benchmark name
+ * and then metric. A benchmark that appears more than once, for example when
+ * several runs were appended to one file, is summarized by its median.
+ */
+using Samples = std::map<std::string, std::map<std::string, std::vector<double>>>;
+
+bool read_results(const char* const path, Samples& samples) {
+	FILE* const file = fopen(path, "r");
+
+	if (file == nullptr) {
+		fprintf(stderr, "cannot open %s\n", path);
+		return false;
+	}
+
+	std::string line;
+	char        buffer[4096];
+
+	while (fgets(buffer, sizeof(buffer), file) != nullptr) {
+		line += buffer;
+
+		if (line.empty() || line.back() != '\n') {
+			continue;
+		}
+
+		Record record;
+		if (parse_record(line, record) && record.count("scenario") != 0 && record["valid"] != "false") {
+			for (const Metric& metric : METRICS) {
+				const auto it = record.find(metric.key);
+
+				if (record["scenario"] == metric.scenario && it != record.end()) {
+					samples[benchmark_name(record)][metric.key].push_back(strtod(it->second.c_str(), nullptr));
+				}
+			}
+		}
+
+		line.clear();
+	}
+
+	fclose(file);
+
+	return true;
+}
+
+double median(std::vector<double> values) {
+	std::sort(values.begin(), values.end());
+
+	const size_t middle = values.size() / 2;
+
+	return values.size() % 2 == 1 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+bool is_higher_better(const std::string& benchmark, const std::string& key) {
+	for (const Metric& metric : METRICS) {
+		if (key == metric.key && benchmark.compare(0, benchmark.find('/'), metric.scenario) == 0) {
+			return metric.higher_is_better;
+		}
+	}
+
+	return false;
+}
+} // namespace
+
+bool compare_results(const char* const baseline_path, const char* const current_path, const double threshold_pct) {
+	Samples baseline;
+	Samples current;
+
+	if (!read_results(baseline_path, baseline) || !read_results(current_path, current)) {
+		return false;
+	}
+
+	uint64_t compared     = 0;
+	uint64_t regressions  = 0;
+	uint64_t improvements = 0;
+	uint64_t missing      = 0;
+
+	for (const auto& [benchmark, metrics] : baseline) {
+		for (const auto& [key, values] : metrics) {
+			const auto benchmark_it = current.find(benchmark);
+
+			if (benchmark_it == current.end() || benchmark_it->second.count(key) == 0) {
+				missing++;
+				Result("compare")
+					.add("benchmark", benchmark)
+					.add("metric", key)
+					.add("status", "missing")
+					.print();
+				continue;
+			}
+
+			const double before = median(values);
+			const double after  = median(benchmark_it->second.at(key));
+
+			// positive when the metric got better, whichever way better is
+			double better_pct = 0;
+			if (before != 0) {
+				better_pct = (after - before) / before * 100.0;
+
+				if (!is_higher_better(benchmark, key)) {
+					better_pct = -better_pct;
+				}
+			}
+
+			const char* status = "unchanged";
+			if (better_pct < -threshold_pct) {
+				status = "regression";
+				regressions++;
+			} else if (better_pct > threshold_pct) {
+				status = "improvement";
+				improvements++;
+			}
+
+			compared++;
+			Result("compare")
+				.add("benchmark", benchmark)
+				.add("metric", key)
+				.add("baseline", before)
+				.add("current", after)
+				.add("better_pct", better_pct)
+				.add("status", status)
+				.print();
+		}
+	}
+
+	Result("compare_summary")
+		.add("baseline", baseline_path)
+		.add("current", current_path)
+		.add("threshold_pct", threshold_pct)
+		.add("compared", compared)
+		.add("regressions", regressions)
+		.add("improvements", improvements)
+		.add("missing", missing)
+		.add("valid", regressions == 0 ? "true" : "false")
+		.print();
+
+	return regressions == 0;
+}
+} // namespace lfmq::bench
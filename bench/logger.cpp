@@ -0,0 +1,134 @@
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "bench_common.hpp"
+#include "lfmq/logger.hpp"
+
+namespace lfmq::bench
+{
+namespace
+{
+constexpr size_t LOG_THREADS = 2;
+
+/// Below LOG_BUFFER_SIZE, so that nothing is dropped while the writer waits for stop
+constexpr size_t RECORDS_PER_THREAD = 1'000;
+} // namespace
+
+/*
+ * Logs from several threads, with and without arguments, and reads the file
+ * back: every line must be there, rendered through its format, each thread's
+ * lines in order and the batch sorted by timestamp
+ */
+bool run_logger(const Options&) {
+	const std::string path = (std::filesystem::temp_directory_path() / ("lfmq_bench_" + std::to_string(getpid()) + ".log")).string();
+	std::remove(path.c_str());
+
+	LogWriter writer;
+
+	// never drains on its own, so every line ends up in the one batch written by stop
+	if (!writer.start(path.c_str(), LogLevel::INFO, std::chrono::hours(1))) {
+		fprintf(stderr, "logger: cannot write %s\n", path.c_str());
+		return false;
+	}
+
+	std::vector<uint64_t>    elapsed(LOG_THREADS, 0);
+	std::vector<std::thread> threads;
+
+	for (size_t t = 0; t < LOG_THREADS; t++) {
+		threads.emplace_back([t, &elapsed] {
+			const std::string name = "logger " + std::to_string(t);
+			register_log_thread(name.c_str());
+
+			const uint64_t start_ns = now_ns();
+			for (uint64_t i = 0; i < RECORDS_PER_THREAD; i++) {
+				log_event(LogLevel::INFO, "thread %d record %" PRIu64, static_cast<int>(t), i);
+			}
+			elapsed[t] = now_ns() - start_ns;
+		});
+	}
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	log_event(LogLevel::INFO, "100%% done");
+	log_event(LogLevel::INFO, "%d%% done", 100);
+	log_event(LogLevel::VERBOSE, "below the level, never written");
+
+	writer.stop();
+
+	FILE* const file = fopen(path.c_str(), "r");
+	if (file == nullptr) {
+		fprintf(stderr, "logger: cannot read %s\n", path.c_str());
+		return false;
+	}
+
+	std::vector<uint64_t> next(LOG_THREADS, 0);
+	uint64_t              lines         = 0;
+	uint64_t              last_ns       = 0;
+	uint64_t              percent_lines = 0;
+	bool                  sorted        = true;
+	bool                  in_order      = true;
+	bool                  unformatted   = false;
+	char                  line[512];
+
+	while (fgets(line, sizeof(line), file) != nullptr) {
+		unsigned long long seconds     = 0;
+		unsigned long long nanoseconds = 0;
+
+		if (sscanf(line, "%llu.%llu", &seconds, &nanoseconds) == 2) {
+			const uint64_t timestamp_ns = seconds * 1'000'000'000 + nanoseconds;
+			sorted  = sorted && timestamp_ns >= last_ns;
+			last_ns = timestamp_ns;
+		}
+
+		int      thread = 0;
+		uint64_t record = 0;
+		const char* const text = strchr(line, ']');
+
+		if (text != nullptr && sscanf(text, "] thread %d record %" SCNu64, &thread, &record) == 2) {
+			const bool known = thread >= 0 && static_cast<size_t>(thread) < LOG_THREADS;
+			in_order = in_order && known && record == next[thread];
+			if (known) {
+				next[thread]++;
+			}
+		} else if (text != nullptr && strcmp(text, "] 100% done\n") == 0) {
+			percent_lines++;
+		}
+
+		unformatted = unformatted || strstr(line, "%%") != nullptr || strstr(line, "never written") != nullptr;
+		lines++;
+	}
+
+	fclose(file);
+	std::remove(path.c_str());
+
+	uint64_t total_ns = 0;
+	for (const uint64_t ns : elapsed) {
+		total_ns += ns;
+	}
+
+	const uint64_t expected = LOG_THREADS * RECORDS_PER_THREAD + 2;
+	const bool     valid    = lines == expected && writer.records_written() == expected && percent_lines == 2 && sorted && in_order && !unformatted;
+
+	Result("logger")
+		.add("threads", static_cast<uint64_t>(LOG_THREADS))
+		.add("records", expected)
+		.add("lines", lines)
+		.add("records_written", writer.records_written())
+		.add("ns_per_event", static_cast<double>(total_ns) / static_cast<double>(LOG_THREADS * RECORDS_PER_THREAD))
+		.add("sorted", sorted ? "true" : "false")
+		.add("in_order", in_order ? "true" : "false")
+		.add("valid", valid ? "true" : "false")
+		.print();
+
+	return valid;
+}
+} // namespace lfmq::bench
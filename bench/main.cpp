@@ -0,0 +1,164 @@
+#include <cstdlib>
+#include <cstring>
+
+#include "bench_common.hpp"
+
+using namespace lfmq::bench;
+
+namespace
+{
+/// Change in percent that --compare reports as a regression unless told otherwise
+constexpr double DEFAULT_THRESHOLD_PCT = 5.0;
+
+constexpr Scenario SCENARIOS[] = {
+	{ "throughput", "messages/sec between a producer and a consumer thread",                     run_throughput,     true },
+	{ "pingpong",   "round trip latency percentiles between two threads",                         run_ping_pong,      true },
+	{ "audio",      "audio callback at 64/128/256 frames @ 48 kHz draining a bursty controller",  run_audio_callback, true },
+	{ "stress",     "randomized FIFO, loss and duplication checks under jitter and CPU placement", run_stress,         false },
+	{ "model",      "checks SpscQueue interleavings against a simulated C++ memory model",        run_model,          false },
+	{ "matrix",     "round trip latency between every pair of CPUs, with the caches they share",  run_matrix,         false },
+	{ "logger",     "logs from several threads and checks the file the LogWriter wrote",          run_logger,         false },
+	{ "notifier",   "consumer waiting in epoll on an EventNotifier, fails on a lost wakeup",      run_notifier,       false },
+};
+
+void print_usage(const char* const program) {
+	fprintf(stderr, "usage: %s [options] [scenario...]\n", program);
+	fprintf(stderr, "       %s --compare BASELINE CURRENT [--threshold PCT]\n\n", program);
+	fprintf(stderr, "Results are printed to stdout as one JSON object per line.\n\n");
+	fprintf(stderr, "scenarios (the ones marked with * run if none are given):\n");
+	for (const Scenario& scenario : SCENARIOS) {
+		fprintf(stderr, "  %-12s %s %s\n", scenario.name, scenario.run_by_default ? "*" : " ", scenario.description);
+	}
+	fprintf(stderr, "\noptions:\n");
+	fprintf(stderr, "  --messages N       messages per throughput run (default %zu)\n", Options().messages);
+	fprintf(stderr, "  --round-trips N    round trips per latency run (default %zu)\n", Options().round_trips);
+	fprintf(stderr, "  --producer-cpu N   pin the producer thread to CPU N\n");
+	fprintf(stderr, "  --consumer-cpu N   pin the consumer thread to CPU N\n");
+	fprintf(stderr, "  --duration-ms N    length of every timed simulation (default %zu)\n", Options().duration_ms);
+	fprintf(stderr, "  --burst-max N      largest burst sent by the simulated controller (default %zu)\n", Options().burst_max);
+	fprintf(stderr, "  --no-perf          do not read hardware performance counters\n");
+	fprintf(stderr, "  --iterations N     randomized stress runs (default %zu)\n", Options().iterations);
+	fprintf(stderr, "  --stress-messages N messages per stress run (default %zu)\n", Options().stress_messages);
+	fprintf(stderr, "  --stress-iteration N only run stress iteration N of --seed, as printed by a failure\n");
+	fprintf(stderr, "  --seed N           seed of the randomized scenarios (default %llu)\n", static_cast<unsigned long long>(Options().seed));
+	fprintf(stderr, "  --no-baselines     only run SpscQueue, not the mutex/deque and seq_cst ring baselines\n");
+	fprintf(stderr, "  --mapped-storage   also run SpscQueue with its ring on huge, pre-faulted and locked pages\n");
+	fprintf(stderr, "  --rt-priority N    run the pingpong and matrix threads with SCHED_FIFO priority N\n");
+	fprintf(stderr, "  --output FILE      also write the results to FILE, to be used as a baseline later\n");
+	fprintf(stderr, "  --compare A B      compare the results in B against the baseline results in A\n");
+	fprintf(stderr, "  --threshold PCT    change in percent --compare reports as a regression (default %.1f)\n", DEFAULT_THRESHOLD_PCT);
+	fprintf(stderr, "\nThe exit status is non-zero if any scenario detected an error or --compare found a regression.\n");
+}
+
+const Scenario* find_scenario(const char* const name) {
+	for (const Scenario& scenario : SCENARIOS) {
+		if (strcmp(scenario.name, name) == 0) {
+			return &scenario;
+		}
+	}
+
+	return nullptr;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+	Options                      options;
+	std::vector<const Scenario*> scenarios;
+	const char*                  output_path   = nullptr;
+	const char*                  baseline_path = nullptr;
+	const char*                  current_path  = nullptr;
+	double                       threshold_pct = DEFAULT_THRESHOLD_PCT;
+
+	for (int i = 1; i < argc; i++) {
+		const char* const arg        = argv[i];
+		const bool        has_value  = i + 1 < argc;
+
+		if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+			print_usage(argv[0]);
+			return EXIT_SUCCESS;
+		} else if (strcmp(arg, "--messages") == 0 && has_value) {
+			options.messages = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(arg, "--round-trips") == 0 && has_value) {
+			options.round_trips = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(arg, "--producer-cpu") == 0 && has_value) {
+			options.producer_cpu = atoi(argv[++i]);
+		} else if (strcmp(arg, "--consumer-cpu") == 0 && has_value) {
+			options.consumer_cpu = atoi(argv[++i]);
+		} else if (strcmp(arg, "--duration-ms") == 0 && has_value) {
+			options.duration_ms = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(arg, "--iterations") == 0 && has_value) {
+			options.iterations = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(arg, "--stress-messages") == 0 && has_value) {
+			options.stress_messages = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(arg, "--stress-iteration") == 0 && has_value) {
+			options.stress_iteration = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(arg, "--seed") == 0 && has_value) {
+			options.seed = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(arg, "--no-baselines") == 0) {
+			options.baselines = false;
+		} else if (strcmp(arg, "--mapped-storage") == 0) {
+			options.mapped_storage = true;
+		} else if (strcmp(arg, "--rt-priority") == 0 && has_value) {
+			options.rt_priority = atoi(argv[++i]);
+		} else if (strcmp(arg, "--output") == 0 && has_value) {
+			output_path = argv[++i];
+		} else if (strcmp(arg, "--compare") == 0 && i + 2 < argc) {
+			baseline_path = argv[++i];
+			current_path  = argv[++i];
+		} else if (strcmp(arg, "--threshold") == 0 && has_value) {
+			threshold_pct = strtod(argv[++i], nullptr);
+		} else if (strcmp(arg, "--no-perf") == 0) {
+			options.perf_counters = false;
+		} else if (strcmp(arg, "--burst-max") == 0 && has_value) {
+			options.burst_max = std::max<size_t>(1, strtoull(argv[++i], nullptr, 10));
+		} else if (const Scenario* const scenario = find_scenario(arg); scenario != nullptr) {
+			scenarios.push_back(scenario);
+		} else {
+			fprintf(stderr, "unknown argument: %s\n\n", arg);
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	FILE* output = nullptr;
+	if (output_path != nullptr) {
+		output = fopen(output_path, "w");
+
+		if (output == nullptr) {
+			fprintf(stderr, "cannot open %s\n", output_path);
+			return EXIT_FAILURE;
+		}
+
+		Result::copy_to(output);
+	}
+
+	if (baseline_path != nullptr) {
+		const bool passed = compare_results(baseline_path, current_path, threshold_pct);
+
+		if (output != nullptr) {
+			fclose(output);
+		}
+
+		return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	if (scenarios.empty()) {
+		for (const Scenario& scenario : SCENARIOS) {
+			if (scenario.run_by_default) {
+				scenarios.push_back(&scenario);
+			}
+		}
+	}
+
+	bool valid = true;
+	for (const Scenario* const scenario : scenarios) {
+		valid = scenario->run(options) && valid;
+	}
+
+	if (output != nullptr) {
+		Result::copy_to(nullptr);
+		fclose(output);
+	}
+
+	return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
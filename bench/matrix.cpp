@@ -0,0 +1,209 @@
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "bench_common.hpp"
+#include "lfmq/lock_free_queue.hpp"
+
+namespace lfmq::bench
+{
+namespace
+{
+constexpr size_t CAPACITY = 64;
+
+/// The matrix runs a ping-pong for every pair of CPUs, so each one gets a tenth of --round-trips
+constexpr size_t ROUND_TRIP_DIVISOR = 10;
+
+/**
+ * @brief Time round trips of a uint64_t between a thread on initiator_cpu and one on echo_cpu
+ * @param samples Filled with the round trip time of every round trip after the warmup
+ * @param rt_applied Set to whether --rt-priority, if given, could be applied to both threads
+ * @return Whether both threads ran where they were pinned and every element came back
+ */
+bool measure_pair(const Options& options, const int initiator_cpu, const int echo_cpu, const size_t round_trips, std::vector<uint64_t>& samples, bool& rt_applied) {
+	const size_t warmup = std::min<size_t>(1'000, round_trips / 10);
+	const size_t total  = warmup + round_trips;
+
+	auto              ping   = std::make_unique<SpscQueue<uint64_t, CAPACITY>>();
+	auto              pong   = std::make_unique<SpscQueue<uint64_t, CAPACITY>>();
+	std::atomic<bool> ready    = false;
+	std::atomic<bool> pinned   = true;
+	std::atomic<bool> realtime = true;
+
+	std::thread echo([&] {
+		if (!pin_this_thread(echo_cpu)) {
+			pinned.store(false);
+		}
+		if (!apply_rt_priority(options)) {
+			realtime.store(false);
+		}
+		ready.store(true);
+
+		uint64_t element;
+		Backoff  backoff;
+
+		for (size_t i = 0; i < total; i++) {
+			while (!ping->pop(&element)) {
+				backoff.pause();
+			}
+			backoff.reset();
+
+			while (!pong->push(element)) {
+				backoff.pause();
+			}
+			backoff.reset();
+		}
+	});
+
+	samples.clear();
+	samples.reserve(round_trips);
+	bool valid = true;
+
+	std::thread initiator([&] {
+		if (!pin_this_thread(initiator_cpu)) {
+			pinned.store(false);
+		}
+		if (!apply_rt_priority(options)) {
+			realtime.store(false);
+		}
+		while (!ready.load()) { }
+
+		uint64_t element;
+		Backoff  backoff;
+
+		for (size_t i = 0; i < total; i++) {
+			const uint64_t start_ns = now_ns();
+
+			while (!ping->push(i)) {
+				backoff.pause();
+			}
+			backoff.reset();
+
+			while (!pong->pop(&element)) {
+				backoff.pause();
+			}
+			backoff.reset();
+
+			const uint64_t end_ns = now_ns();
+
+			valid = valid && element == i;
+			if (i >= warmup) {
+				samples.push_back(end_ns - start_ns);
+			}
+		}
+	});
+
+	initiator.join();
+	echo.join();
+
+	rt_applied = realtime.load();
+
+	return valid && pinned.load();
+}
+} // namespace
+
+/*
+ * Round trip latency between every pair of CPUs the process may run on,
+ * next to how the pair shares caches according to CpuTopology, so that the
+ * producer and consumer of a queue can be placed on the fastest pair
+ */
+bool run_matrix(const Options& options) {
+	const CpuTopology topology    = CpuTopology::read();
+	const auto&       cpus        = topology.cpus();
+	const size_t      round_trips = std::max<size_t>(1, options.round_trips / ROUND_TRIP_DIVISOR);
+
+	for (const CpuTopology::Cpu& cpu : cpus) {
+		Result("matrix_cpu")
+			.add("cpu", cpu.cpu)
+			.add("core", cpu.core)
+			.add("l2", cpu.l2)
+			.add("l3", cpu.l3)
+			.add("package", cpu.package)
+			.print();
+	}
+
+	// p50 of every pair, printed as a table once every pair was measured
+	std::vector<uint64_t> p50s(cpus.size() * cpus.size(), 0);
+	std::vector<uint64_t> samples;
+	bool                  valid      = true;
+	bool                  rt_applied = true;
+	uint64_t              pairs      = 0;
+	size_t                best       = SIZE_MAX;
+
+	for (size_t i = 0; i < cpus.size(); i++) {
+		for (size_t j = i + 1; j < cpus.size(); j++) {
+			bool              pair_rt    = true;
+			const bool        pair_valid = measure_pair(options, cpus[i].cpu, cpus[j].cpu, round_trips, samples, pair_rt);
+			const Percentiles rtt        = Percentiles::of(samples);
+
+			Result result("matrix");
+			result.add("producer_cpu", cpus[i].cpu)
+				.add("consumer_cpu", cpus[j].cpu)
+				.add("distance", cpu_distance_name(topology.distance(cpus[i].cpu, cpus[j].cpu)))
+				.add("round_trips", static_cast<uint64_t>(samples.size()));
+			rtt.add_to(result, "rtt_ns");
+			result.add("valid", pair_valid ? "true" : "false");
+			if (options.rt_priority > 0) {
+				result.add("rt_applied", pair_rt ? "true" : "false");
+			}
+			result.print();
+
+			p50s[i * cpus.size() + j] = rtt.p50;
+			p50s[j * cpus.size() + i] = rtt.p50;
+
+			if (pair_valid && (best == SIZE_MAX || rtt.p50 < p50s[best])) {
+				best = i * cpus.size() + j;
+			}
+
+			valid      = valid && pair_valid;
+			rt_applied = rt_applied && pair_rt;
+			pairs++;
+		}
+	}
+
+	int               first    = 0;
+	int               second   = 0;
+	const CpuDistance distance = topology.closest_pair(first, second);
+
+	Result summary("matrix_summary");
+	summary.add("cpus", static_cast<uint64_t>(cpus.size()))
+		.add("pairs", pairs)
+		.add("closest_pair", std::to_string(first) + "," + std::to_string(second))
+		.add("closest_distance", cpu_distance_name(distance));
+
+	if (best != SIZE_MAX) {
+		summary.add("fastest_pair", std::to_string(cpus[best / cpus.size()].cpu) + "," + std::to_string(cpus[best % cpus.size()].cpu))
+			.add("fastest_rtt_ns_p50", p50s[best]);
+	}
+
+	if (options.rt_priority > 0) {
+		summary.add("rt_priority", options.rt_priority)
+			.add("rt_applied", rt_applied ? "true" : "false");
+	}
+
+	summary.add("valid", valid ? "true" : "false").print();
+
+	// the JSON lines above are for tools, the table on stderr is for reading
+	fprintf(stderr, "round trip p50 (ns)\n%6s", "");
+	for (const CpuTopology::Cpu& cpu : cpus) {
+		fprintf(stderr, " %7d", cpu.cpu);
+	}
+	fprintf(stderr, "\n");
+
+	for (size_t i = 0; i < cpus.size(); i++) {
+		fprintf(stderr, "%6d", cpus[i].cpu);
+
+		for (size_t j = 0; j < cpus.size(); j++) {
+			if (i == j) {
+				fprintf(stderr, " %7s", "-");
+			} else {
+				fprintf(stderr, " %7llu", static_cast<unsigned long long>(p50s[i * cpus.size() + j]));
+			}
+		}
+
+		fprintf(stderr, "\n");
+	}
+
+	return valid;
+}
+} // namespace lfmq::bench
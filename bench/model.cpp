@@ -0,0 +1,411 @@
+#include <atomic>
+
+#include "bench_common.hpp"
+#include "lfmq/epoch_domain.hpp"
+#include "lfmq/hazard_domain.hpp"
+#include "lfmq/lock_free_queue.hpp"
+#include "lfmq/model_checker.hpp"
+#include "lfmq/parameter_store.hpp"
+#include "lfmq/rcu_snapshot.hpp"
+
+namespace lfmq::bench
+{
+namespace
+{
+using model::Atomic;
+using model::Var;
+using model::check;
+
+template <size_t _size>
+using ModelQueue = SpscQueue<Var<uint64_t>, _size, model::ModelQueueTraits>;
+
+/// Times a producer retries a push on a full queue, or a consumer a pop on an empty one
+constexpr size_t ATTEMPTS = 2;
+
+/*
+ * Pushes more elements than the queue holds so that both indices wrap and
+ * the producer runs into a full queue, while the consumer pops them with
+ * both pop(&element) and front() + pop(nullptr)
+ */
+struct QueueTest {
+	static constexpr size_t   THREADS  = 2;
+	static constexpr uint64_t MESSAGES = 4;
+
+	ModelQueue<3> queue;
+	uint64_t      pushed   = 0;
+	uint64_t      expected = 1;
+
+	void thread(const size_t index) {
+		if (index == 0) {
+			for (uint64_t value = 1; value <= MESSAGES; value++) {
+				size_t attempt = 0;
+				while (attempt < ATTEMPTS && !this->queue.push(Var<uint64_t>(value))) {
+					attempt++;
+				}
+
+				if (attempt == ATTEMPTS) {
+					return;
+				}
+
+				this->pushed = value;
+			}
+		} else {
+			for (size_t attempt = 0; attempt < MESSAGES * ATTEMPTS && this->expected <= MESSAGES; attempt++) {
+				this->consume(attempt % 2 == 0);
+			}
+		}
+	}
+
+	void consume(const bool use_front) {
+		Var<uint64_t> element;
+
+		if (use_front) {
+			if (this->queue.is_empty()) {
+				return;
+			}
+
+			element = this->queue.front();
+			this->queue.pop(nullptr);
+		} else if (!this->queue.pop(&element)) {
+			return;
+		}
+
+		check(element.get() == this->expected, "popped an element out of order");
+		this->expected++;
+	}
+
+	void finish() {
+		while (!this->queue.is_empty()) {
+			this->consume(false);
+		}
+
+		check(this->expected == this->pushed + 1, "an element that was pushed was never popped");
+	}
+};
+
+/*
+ * Publishes elements in committed frames next to an aborted one. The
+ * consumer must only ever see committed elements, in order.
+ */
+struct FrameTest {
+	static constexpr size_t THREADS = 2;
+
+	ModelQueue<4> queue;
+	uint64_t      committed = 0;
+	uint64_t      expected  = 1;
+
+	void thread(const size_t index) {
+		if (index == 0) {
+			auto frame = this->queue.begin_frame();
+
+			frame.push(Var<uint64_t>(1));
+			frame.push(Var<uint64_t>(2));
+			frame.commit();
+			this->committed = 2;
+
+			frame.push(Var<uint64_t>(100));
+			frame.abort();
+
+			for (size_t attempt = 0; attempt < ATTEMPTS; attempt++) {
+				if (frame.push(Var<uint64_t>(3))) {
+					frame.commit();
+					this->committed = 3;
+					return;
+				}
+			}
+		} else {
+			Var<uint64_t> element;
+
+			for (size_t attempt = 0; attempt < 2 * ATTEMPTS; attempt++) {
+				if (this->queue.pop(&element)) {
+					check(element.get() == this->expected, "popped an uncommitted or out of order element");
+					this->expected++;
+				}
+			}
+		}
+	}
+
+	void finish() {
+		Var<uint64_t> element;
+
+		while (this->queue.pop(&element)) {
+			check(element.get() == this->expected, "popped an uncommitted or out of order element");
+			this->expected++;
+		}
+
+		check(this->expected == this->committed + 1, "a committed element was never popped");
+	}
+};
+
+/*
+ * A controller sets parameters in two groups, one of them twice, while the
+ * audio thread polls. Whenever the audio thread takes a dirty bit it must
+ * also see the value that set it, otherwise the bit is gone and the final
+ * poll never delivers the latest value.
+ */
+struct ParameterStoreTest {
+	static constexpr size_t THREADS = 2;
+
+	ParameterStore<float, 32, model::ModelQueueTraits> store;
+	float                                              seen[32] = {};
+
+	void thread(const size_t index) {
+		if (index == 0) {
+			this->store.set(0, 1.0f);
+			this->store.set(20, 2.0f);
+			this->store.set(0, 3.0f);
+		} else {
+			for (size_t attempt = 0; attempt < ATTEMPTS; attempt++) {
+				this->poll();
+			}
+		}
+	}
+
+	void poll() {
+		this->store.for_each_changed([&](const size_t index, const float value) {
+			this->seen[index] = value;
+		});
+	}
+
+	void finish() {
+		this->poll();
+		check(this->seen[0] == 3.0f && this->seen[20] == 2.0f, "a parameter change was lost");
+	}
+};
+
+/*
+ * The controller publishes two snapshots while the audio thread reads one
+ * per block. Deleting a snapshot writes its Var, so reclaiming one the
+ * reader may still be using shows up as a data race.
+ */
+struct RcuSnapshotTest {
+	static constexpr size_t THREADS = 2;
+
+	struct Snapshot {
+		Var<int> version;
+	};
+
+	RcuSnapshot<Snapshot, model::ModelQueueTraits> snapshot{ std::make_unique<Snapshot>(Snapshot{ 1 }) };
+
+	void thread(const size_t index) {
+		if (index == 0) {
+			this->snapshot.publish(std::make_unique<Snapshot>(Snapshot{ 2 }));
+			this->snapshot.publish(std::make_unique<Snapshot>(Snapshot{ 3 }));
+			this->snapshot.reclaim();
+		} else {
+			int last = 0;
+
+			for (size_t block = 0; block < 3; block++) {
+				const int version = this->snapshot.read()->version.get();
+
+				check(version >= last, "read an older snapshot after a newer one");
+				last = version;
+			}
+		}
+	}
+
+	void finish() {
+		check(this->snapshot.latest()->version.get() == 3, "the last published snapshot is not the latest");
+	}
+};
+
+/*
+ * The reclaimer replaces a shared node twice and collects after each
+ * replacement while a reader dereferences the node inside critical sections.
+ * Deleting a node writes its Var, so freeing one the reader may still be
+ * using shows up as a data race.
+ */
+struct EpochDomainTest {
+	static constexpr size_t THREADS = 2;
+
+	struct Node {
+		Var<int> version;
+	};
+
+	using Domain = EpochDomain<2, model::ModelQueueTraits>;
+
+	Domain         domain;
+	Domain::Reader reader;
+	Atomic<Node*>  shared = new Node{ 1 };
+
+	EpochDomainTest() {
+		this->domain.register_reader(this->reader);
+	}
+
+	~EpochDomainTest() {
+		delete this->shared.load(std::memory_order_relaxed);
+	}
+
+	void thread(const size_t index) {
+		if (index == 0) {
+			for (int version = 2; version <= 3; version++) {
+				this->domain.retire(this->shared.exchange(new Node{ version }, std::memory_order_seq_cst));
+				this->domain.collect();
+			}
+		} else {
+			int last = 0;
+
+			for (size_t section = 0; section < 2; section++) {
+				Domain::Guard guard(this->reader);
+				const int     version = this->shared.load(std::memory_order_seq_cst)->version.get();
+
+				check(version >= last, "read an older node after a newer one");
+				last = version;
+			}
+		}
+	}
+
+	void finish() {
+		this->domain.collect();
+		check(this->domain.retired_count() == 0, "a retired node was not freed once the reader was quiescent");
+	}
+};
+
+/*
+ * Same as EpochDomainTest, with the reader protecting the node with a hazard
+ * pointer and the reclaimer scanning after each replacement
+ */
+struct HazardDomainTest {
+	static constexpr size_t THREADS = 2;
+
+	struct Node {
+		Var<int> version;
+	};
+
+	using Domain = HazardDomain<1, 1, 3, model::ModelQueueTraits>;
+
+	Domain         domain;
+	Domain::Reader reader;
+	Atomic<Node*>  shared = new Node{ 1 };
+
+	HazardDomainTest() {
+		this->domain.register_reader(this->reader);
+	}
+
+	~HazardDomainTest() {
+		delete this->shared.load(std::memory_order_relaxed);
+	}
+
+	void thread(const size_t index) {
+		if (index == 0) {
+			for (int version = 2; version <= 3; version++) {
+				this->domain.retire(this->shared.exchange(new Node{ version }, std::memory_order_seq_cst));
+				this->domain.scan();
+			}
+		} else {
+			int last = 0;
+
+			for (size_t attempt = 0; attempt < 2; attempt++) {
+				Node* node = nullptr;
+
+				if (!this->reader.try_protect(0, this->shared, node)) {
+					continue;
+				}
+
+				const int version = node->version.get();
+				this->reader.clear(0);
+
+				check(version >= last, "read an older node after a newer one");
+				last = version;
+			}
+		}
+	}
+
+	void finish() {
+		this->domain.scan();
+		check(this->domain.retired_count() == 0, "a retired node was not freed once no hazard protected it");
+	}
+};
+
+/*
+ * Self tests of the checker: message passing through a flag and store
+ * buffering are the classic litmus tests. The weaker variant of each must
+ * be caught, otherwise a passing queue test proves nothing.
+ */
+template <std::memory_order _store, std::memory_order _load>
+struct MessagePassingTest {
+	static constexpr size_t THREADS = 2;
+
+	Var<int>     data;
+	Atomic<bool> ready = false;
+
+	void thread(const size_t index) {
+		if (index == 0) {
+			this->data = 42;
+			this->ready.store(true, _store);
+		} else if (this->ready.load(_load)) {
+			check(this->data.get() == 42, "read the flag but not the data");
+		}
+	}
+
+	void finish() { }
+};
+
+template <std::memory_order _store, std::memory_order _load>
+struct StoreBufferingTest {
+	static constexpr size_t THREADS = 2;
+
+	Atomic<int> x = 0;
+	Atomic<int> y = 0;
+	int         seen[THREADS] = {};
+
+	void thread(const size_t index) {
+		Atomic<int>& mine   = index == 0 ? this->x : this->y;
+		Atomic<int>& theirs = index == 0 ? this->y : this->x;
+
+		mine.store(1, _store);
+		this->seen[index] = theirs.load(_load);
+	}
+
+	void finish() {
+		check(this->seen[0] == 1 || this->seen[1] == 1, "both threads missed the other's store");
+	}
+};
+
+template <typename _Test>
+bool run_check(const char* const name, const bool expect_failure, const size_t preemption_bound) {
+	model::CheckOptions options;
+	options.preemption_bound = preemption_bound;
+
+	const model::CheckReport report = model::check_model<_Test>(options);
+	const bool               valid  = report.passed() != expect_failure;
+
+	Result result("model");
+	result.add("test", name)
+		.add("executions", report.executions)
+		.add("preemption_bound", static_cast<uint64_t>(preemption_bound))
+		.add("exhausted", report.exhausted ? "true" : "false")
+		.add("expected", expect_failure ? "failure" : "pass");
+
+	if (!report.passed()) {
+		result.add("failure", report.failure);
+	}
+
+	result.add("valid", valid ? "true" : "false").print();
+
+	return valid;
+}
+} // namespace
+
+bool run_model(const Options&) {
+	constexpr auto relaxed = std::memory_order_relaxed;
+	constexpr auto acquire = std::memory_order_acquire;
+	constexpr auto release = std::memory_order_release;
+	constexpr auto seq_cst = std::memory_order_seq_cst;
+
+	bool valid = true;
+
+	valid &= run_check<MessagePassingTest<release, acquire>>("message_passing_release_acquire", false, 3);
+	valid &= run_check<MessagePassingTest<relaxed, relaxed>>("message_passing_relaxed", true, 3);
+	valid &= run_check<StoreBufferingTest<seq_cst, seq_cst>>("store_buffering_seq_cst", false, 3);
+	valid &= run_check<StoreBufferingTest<release, acquire>>("store_buffering_release_acquire", true, 3);
+	valid &= run_check<QueueTest>("spsc_queue", false, 2);
+	valid &= run_check<FrameTest>("spsc_queue_frames", false, 3);
+	valid &= run_check<ParameterStoreTest>("parameter_store", false, 3);
+	valid &= run_check<RcuSnapshotTest>("rcu_snapshot", false, 3);
+	valid &= run_check<EpochDomainTest>("epoch_domain", false, 3);
+	valid &= run_check<HazardDomainTest>("hazard_domain", false, 3);
+
+	return valid;
+}
+} // namespace lfmq::bench
@@ -0,0 +1,145 @@
+#include <atomic>
+#include <memory>
+#include <random>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
+#include "bench_common.hpp"
+#include "lfmq/event_notifier.hpp"
+#include "lfmq/lock_free_queue.hpp"
+
+namespace lfmq::bench
+{
+namespace
+{
+constexpr size_t CAPACITY = 1024;
+
+/// The notifier scenario sends a fifth of --messages, it sleeps between bursts so that the consumer really waits
+constexpr size_t MESSAGE_DIVISOR = 5;
+
+/// Largest pause of the producer between two bursts
+constexpr uint64_t MAX_GAP_US = 50;
+
+/// An epoll_wait that times out with elements queued means a wakeup was lost
+constexpr int WAIT_TIMEOUT_MS = 1'000;
+} // namespace
+
+/*
+ * Consumer that sleeps in epoll_wait on an EventNotifier while a producer
+ * pushes bursts at random intervals. The model checker cannot cover the
+ * notifier, since it does not simulate the fences the handshake relies on,
+ * so this runs the handshake on real threads and fails if epoll_wait ever
+ * times out while elements are queued.
+ */
+bool run_notifier(const Options& options) {
+#if defined(__linux__)
+	const uint64_t total = std::max<uint64_t>(1, options.messages / MESSAGE_DIVISOR);
+
+	auto          queue = std::make_unique<SpscQueue<uint64_t, CAPACITY>>();
+	EventNotifier notifier;
+	const int     epoll = epoll_create1(EPOLL_CLOEXEC);
+
+	epoll_event event{};
+	event.events = EPOLLIN;
+
+	if (!notifier.open() || epoll < 0 || epoll_ctl(epoll, EPOLL_CTL_ADD, notifier.fd(), &event) != 0) {
+		fprintf(stderr, "notifier: cannot create the eventfd or the epoll set\n");
+		if (epoll >= 0) {
+			close(epoll);
+		}
+		return false;
+	}
+
+	std::atomic<bool> done = false;
+
+	std::thread producer([&] {
+		pin_this_thread(options.producer_cpu);
+
+		std::mt19937_64                         rng(options.seed);
+		std::uniform_int_distribution<size_t>   burst(1, options.burst_max);
+		std::uniform_int_distribution<uint64_t> gap_us(0, MAX_GAP_US);
+		Backoff                                 backoff;
+
+		uint64_t sequence = 0;
+		while (sequence < total) {
+			for (size_t count = burst(rng); count > 0 && sequence < total; count--) {
+				while (!queue->push(sequence)) {
+					backoff.pause();
+				}
+				backoff.reset();
+
+				notifier.notify();
+				sequence++;
+			}
+
+			std::this_thread::sleep_for(std::chrono::microseconds(gap_us(rng)));
+		}
+
+		done.store(true);
+	});
+
+	uint64_t received     = 0;
+	uint64_t wakeups      = 0;
+	uint64_t timeouts     = 0;
+	uint64_t lost_wakeups = 0;
+	bool     in_order     = true;
+
+	std::thread consumer([&] {
+		pin_this_thread(options.consumer_cpu);
+
+		while (received < total) {
+			epoll_event ready{};
+			const int   events = epoll_wait(epoll, &ready, 1, WAIT_TIMEOUT_MS);
+
+			if (events == 0) {
+				timeouts++;
+				lost_wakeups += queue->is_empty() ? 0 : 1;
+
+				// the producer has nothing left to send that would signal again
+				if (done.load() && queue->is_empty()) {
+					break;
+				}
+			} else if (events > 0) {
+				wakeups++;
+				notifier.consume();
+			}
+
+			uint64_t element;
+			do {
+				while (queue->pop(&element)) {
+					in_order = in_order && element == received;
+					received++;
+				}
+			} while (!notifier.arm(*queue));
+		}
+	});
+
+	consumer.join();
+	producer.join();
+	close(epoll);
+
+	const bool valid = received == total && lost_wakeups == 0 && in_order;
+
+	Result("notifier")
+		.add("capacity", static_cast<uint64_t>(CAPACITY))
+		.add("messages", total)
+		.add("received", received)
+		.add("signals", notifier.signal_count())
+		.add("wakeups", wakeups)
+		.add("timeouts", timeouts)
+		.add("lost_wakeups", lost_wakeups)
+		.add("valid", valid ? "true" : "false")
+		.print();
+
+	return valid;
+#else
+	(void)options;
+	fprintf(stderr, "notifier: eventfd is only available on Linux\n");
+	return true;
+#endif
+}
+} // namespace lfmq::bench
@@ -0,0 +1,169 @@
+#include "perf_counters.hpp"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace lfmq::bench
+{
+namespace
+{
+constexpr const char* COUNTER_NAMES[PerfCounters::COUNTER_COUNT] = {
+	"cycles",
+	"instructions",
+	"l1d_misses",
+	"llc_misses",
+	"branch_misses",
+};
+
+#if defined(__linux__)
+constexpr uint64_t hw_cache_config(const uint64_t cache, const uint64_t op, const uint64_t result) noexcept {
+	return cache | (op << 8) | (result << 16);
+}
+
+int open_counter(const PerfCounters::Counter counter) noexcept {
+	perf_event_attr attr{};
+	attr.size           = sizeof(attr);
+	attr.disabled       = 1;
+	attr.inherit        = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv     = 1;
+	// lets stop scale the count when more events are open than the PMU has counters for
+	attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	switch (counter) {
+	case PerfCounters::CYCLES:
+		attr.type   = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_CPU_CYCLES;
+		break;
+	case PerfCounters::INSTRUCTIONS:
+		attr.type   = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+		break;
+	case PerfCounters::L1D_MISSES:
+		attr.type   = PERF_TYPE_HW_CACHE;
+		attr.config = hw_cache_config(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS);
+		break;
+	case PerfCounters::LLC_MISSES:
+		attr.type   = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		break;
+	case PerfCounters::BRANCH_MISSES:
+		attr.type   = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+		break;
+	case PerfCounters::COUNTER_COUNT:
+		return -1;
+	}
+
+	return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+#endif
+} // namespace
+
+/*
+ * Start PerfCounters class definitions
+ */
+PerfCounters::PerfCounters(const bool enabled) {
+	for (int i = 0; i < COUNTER_COUNT; i++) {
+		this->fds[i]    = -1;
+		this->values[i] = 0;
+		this->valid[i]  = false;
+		this->scaled[i] = false;
+
+#if defined(__linux__)
+		if (enabled) {
+			this->fds[i] = open_counter(static_cast<Counter>(i));
+		}
+#else
+		(void)enabled;
+#endif
+	}
+}
+
+PerfCounters::~PerfCounters() {
+#if defined(__linux__)
+	for (const int fd : this->fds) {
+		if (fd >= 0) {
+			close(fd);
+		}
+	}
+#endif
+}
+
+void PerfCounters::start() noexcept {
+#if defined(__linux__)
+	for (const int fd : this->fds) {
+		if (fd >= 0) {
+			ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+#endif
+}
+
+void PerfCounters::stop() noexcept {
+#if defined(__linux__)
+	for (int i = 0; i < COUNTER_COUNT; i++) {
+		if (this->fds[i] < 0) {
+			continue;
+		}
+
+		ioctl(this->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+		// value, time enabled, time running
+		uint64_t values[3] = {};
+		const bool read_all = read(this->fds[i], values, sizeof(values)) == static_cast<ssize_t>(sizeof(values));
+
+		// a counter that never got onto the PMU has nothing to scale
+		this->valid[i]  = read_all && values[2] > 0;
+		this->scaled[i] = this->valid[i] && values[2] < values[1];
+		this->values[i] = this->scaled[i]
+			? static_cast<uint64_t>(static_cast<double>(values[0]) * static_cast<double>(values[1]) / static_cast<double>(values[2]))
+			: values[0];
+	}
+#endif
+}
+
+bool PerfCounters::is_available() const noexcept {
+	for (const int fd : this->fds) {
+		if (fd >= 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void PerfCounters::add_to(Result& result, const uint64_t operations) const {
+	if (operations == 0) {
+		return;
+	}
+
+	bool multiplexed = false;
+	bool any_valid   = false;
+
+	for (int i = 0; i < COUNTER_COUNT; i++) {
+		if (this->valid[i]) {
+			const std::string key = std::string("perf_") + COUNTER_NAMES[i] + "_per_op";
+			result.add(key.c_str(), static_cast<double>(this->values[i]) / static_cast<double>(operations));
+			multiplexed = multiplexed || this->scaled[i];
+			any_valid   = true;
+		}
+	}
+
+	if (any_valid) {
+		result.add("perf_multiplexed", multiplexed ? "true" : "false");
+	}
+
+	if (this->valid[CYCLES] && this->valid[INSTRUCTIONS] && this->values[CYCLES] > 0) {
+		result.add("perf_ipc", static_cast<double>(this->values[INSTRUCTIONS]) / static_cast<double>(this->values[CYCLES]));
+	}
+}
+/*
+ * End PerfCounters class definitions
+ */
+} // namespace lfmq::bench
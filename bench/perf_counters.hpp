@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+
+#include "bench_common.hpp"
+
+namespace lfmq::bench
+{
+/*
+ * Hardware performance counters read with perf_event_open around a
+ * scenario. The counters are opened with inherit set before the scenario
+ * spawns its threads, so they cover every thread of the scenario once those
+ * threads have been joined. Counters that the kernel, the hardware or the
+ * permissions (kernel.perf_event_paranoid) do not allow are skipped, and
+ * nothing is reported when none of them could be opened.
+ *
+ * When more events are open than the PMU has counters, for example with SMT
+ * enabled, the kernel multiplexes them and each one only counts for part of
+ * the run. Such counts are scaled by time enabled over time running, which
+ * makes them estimates, and perf_multiplexed says so in the result.
+ */
+class PerfCounters {
+public:
+	enum Counter {
+		CYCLES,
+		INSTRUCTIONS,
+		L1D_MISSES,
+		LLC_MISSES,
+		BRANCH_MISSES,
+		COUNTER_COUNT
+	};
+
+	/**
+	 * @brief Open the counters, disabled
+	 * @param enabled False to skip opening any counter
+	 */
+	explicit PerfCounters(bool enabled);
+	PerfCounters(const PerfCounters&) = delete;
+	PerfCounters& operator=(const PerfCounters&) = delete;
+	~PerfCounters();
+
+	/**
+	 * @brief Reset and enable every open counter
+	 */
+	void start() noexcept;
+
+	/**
+	 * @brief Disable every open counter and read its value, scaled up if the counter was multiplexed
+	 * @note Call this after the threads of the scenario have been joined
+	 */
+	void stop() noexcept;
+
+	/**
+	 * @brief Return whether at least one counter could be opened
+	 */
+	bool is_available() const noexcept;
+
+	/**
+	 * @brief Add every counter that could be read to result, divided by operations
+	 * @param result Result to add the perf_*_per_op fields to
+	 * @param operations Number of operations the scenario performed
+	 */
+	void add_to(Result& result, uint64_t operations) const;
+
+private:
+	int      fds[COUNTER_COUNT];
+	uint64_t values[COUNTER_COUNT];
+	bool     valid[COUNTER_COUNT];
+	bool     scaled[COUNTER_COUNT]; // Whether the counter only ran for part of the time it was enabled
+};
+} // namespace lfmq::bench
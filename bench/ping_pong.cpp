@@ -0,0 +1,132 @@
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "baselines.hpp"
+#include "bench_common.hpp"
+#include "perf_counters.hpp"
+#include "lfmq/lock_free_queue.hpp"
+
+namespace lfmq::bench
+{
+namespace
+{
+/*
+ * The initiator pushes an element onto the ping queue and waits for the
+ * echo thread to push it back onto the pong queue. Every round trip is timed
+ * on its own, so the result is a latency distribution rather than an average.
+ */
+template<typename _Queue, typename _Kind, size_t _capacity>
+bool run_one(const Options& options) {
+	using Element = typename _Kind::type;
+	using Queue   = typename _Queue::template type<Element, _capacity>;
+
+	const size_t warmup = std::min<size_t>(1'000, options.round_trips / 10);
+	const size_t total  = warmup + options.round_trips;
+
+	auto              ping  = std::make_unique<Queue>();
+	auto              pong  = std::make_unique<Queue>();
+	std::atomic<bool> ready      = false;
+	std::atomic<bool> rt_applied = true;
+	PerfCounters      counters(options.perf_counters);
+
+	counters.start();
+
+	std::thread echo([&] {
+		pin_this_thread(options.consumer_cpu);
+		if (!apply_rt_priority(options)) {
+			rt_applied.store(false);
+		}
+		ready.store(true);
+
+		Element element;
+		Backoff backoff;
+
+		for (size_t i = 0; i < total; i++) {
+			while (!ping->pop(&element)) {
+				backoff.pause();
+			}
+			backoff.reset();
+
+			while (!pong->push(element)) {
+				backoff.pause();
+			}
+			backoff.reset();
+		}
+	});
+
+	std::vector<uint64_t> samples;
+	samples.reserve(options.round_trips);
+	bool valid = true;
+
+	std::thread initiator([&] {
+		pin_this_thread(options.producer_cpu);
+		if (!apply_rt_priority(options)) {
+			rt_applied.store(false);
+		}
+		while (!ready.load()) { }
+
+		Element element;
+		Backoff backoff;
+
+		for (size_t i = 0; i < total; i++) {
+			const Element sent = _Kind::make(i);
+			const uint64_t start_ns = now_ns();
+
+			while (!ping->push(sent)) {
+				backoff.pause();
+			}
+			backoff.reset();
+
+			while (!pong->pop(&element)) {
+				backoff.pause();
+			}
+			backoff.reset();
+
+			const uint64_t end_ns = now_ns();
+
+			valid = valid && _Kind::sequence(element) == i;
+			if (i >= warmup) {
+				samples.push_back(end_ns - start_ns);
+			}
+		}
+	});
+
+	initiator.join();
+	echo.join();
+
+	counters.stop();
+
+	Result result("ping_pong");
+	result.add("queue", _Queue::name)
+		.add("element", _Kind::name)
+		.add("element_size", static_cast<uint64_t>(sizeof(Element)))
+		.add("payload_size", static_cast<uint64_t>(_Kind::payload_size))
+		.add("capacity", static_cast<uint64_t>(_capacity))
+		.add("round_trips", static_cast<uint64_t>(samples.size()));
+	Percentiles::of(samples).add_to(result, "rtt_ns");
+	result.add("valid", valid ? "true" : "false");
+	if (options.rt_priority > 0) {
+		result.add("rt_priority", options.rt_priority)
+			.add("rt_applied", rt_applied.load() ? "true" : "false");
+	}
+	add_storage_to(result, *ping);
+	counters.add_to(result, total);
+	result.print();
+
+	return valid;
+}
+} // namespace
+
+bool run_ping_pong(const Options& options) {
+	bool valid = true;
+
+	for_each_config([&]<typename _Kind, size_t _capacity>() {
+		for_each_queue(options, [&]<typename _Queue>() {
+			valid = run_one<_Queue, _Kind, _capacity>(options) && valid;
+		});
+	});
+
+	return valid;
+}
+} // namespace lfmq::bench
@@ -0,0 +1,320 @@
+#include <atomic>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "bench_common.hpp"
+#include "lfmq/lock_free_queue.hpp"
+
+namespace lfmq::bench
+{
+namespace
+{
+/*
+ * Element whose two halves are written separately, so that a consumer which
+ * reads a slot before the producer has finished writing it sees a checksum
+ * that does not match the sequence number
+ */
+struct SequencedElement {
+	uint64_t sequence = 0;
+	uint64_t checksum = ~uint64_t{ 0 };
+};
+
+struct SequencedKind {
+	using type = SequencedElement;
+
+	static constexpr const char* name = "sequenced";
+
+	static type make(const uint64_t sequence) noexcept {
+		return SequencedElement{ sequence, ~sequence };
+	}
+
+	static bool is_intact(const type& element) noexcept {
+		return element.checksum == ~element.sequence;
+	}
+
+	static uint64_t sequence(const type& element) noexcept {
+		return element.sequence;
+	}
+};
+
+struct StressMessageKind {
+	using type = Message;
+
+	static constexpr const char* name = "Message";
+
+	static type make(const uint64_t sequence) {
+		const SequencedElement payload{ sequence, ~sequence };
+		return Message(MessageMetadata(MessageType::VOLUME), payload);
+	}
+
+	static bool is_intact(const type& element) noexcept {
+		return SequencedKind::is_intact(element.get_payload<SequencedElement>())
+			&& element.get_payload_size() == sizeof(SequencedElement);
+	}
+
+	static uint64_t sequence(const type& element) noexcept {
+		return element.get_payload<SequencedElement>().sequence;
+	}
+};
+
+/*
+ * Random stall used by both sides: usually nothing, sometimes a short spin,
+ * rarely a yield, so that the two threads drift in and out of lock step
+ */
+class Jitter {
+public:
+	explicit Jitter(const uint64_t seed) :
+			rng(seed)
+	{ }
+
+	void operator()() {
+		const uint32_t roll = this->rng() % 1024;
+
+		if (roll < 1000) {
+			return;
+		}
+
+		if (roll < 1020) {
+			const uint32_t spins = this->rng() % 256;
+			for (uint32_t i = 0; i < spins; i++) {
+#if defined(__x86_64__) || defined(__i386__)
+				_mm_pause();
+#endif
+			}
+			return;
+		}
+
+		std::this_thread::yield();
+	}
+
+	uint32_t next(const uint32_t bound) {
+		return static_cast<uint32_t>(this->rng() % bound);
+	}
+
+private:
+	std::mt19937_64 rng;
+};
+
+/// A run that takes longer than this is reported as stuck and abandoned
+constexpr uint64_t RUN_TIMEOUT_NS = 10'000'000'000;
+
+/// Number of loop iterations between checks of the timeout
+constexpr uint64_t TIMEOUT_CHECK_INTERVAL = 1024;
+
+struct RunReport {
+	uint64_t    errors = 0;
+	std::string first_error;
+};
+
+/*
+ * One randomized run. The producer pushes sequence numbers 0..messages-1,
+ * sometimes one at a time and sometimes as committed or aborted frames. The
+ * consumer either pops into an element or peeks at front() and discards with
+ * pop(nullptr), and checks that every element arrives intact, exactly once
+ * and in order.
+ */
+template<typename _Kind, size_t _capacity>
+RunReport run_once(const Options& options, const uint64_t seed, const int producer_cpu, const int consumer_cpu) {
+	using Element = typename _Kind::type;
+
+	auto              queue    = std::make_unique<SpscQueue<Element, _capacity>>();
+	std::atomic<int>  ready    = 0;
+	std::atomic<bool> stuck    = false;
+	const uint64_t    deadline = now_ns() + RUN_TIMEOUT_NS;
+	RunReport         report;
+
+	// called by both sides every TIMEOUT_CHECK_INTERVAL loop iterations
+	const auto is_stuck = [&](uint64_t& loops) {
+		if (++loops % TIMEOUT_CHECK_INTERVAL == 0 && now_ns() > deadline) {
+			stuck.store(true);
+		}
+
+		return stuck.load(std::memory_order_relaxed);
+	};
+
+	const auto fail = [&](const std::string& error) {
+		if (report.errors++ == 0) {
+			report.first_error = error;
+		}
+	};
+
+	std::thread consumer([&] {
+		pin_this_thread(consumer_cpu);
+		ready.fetch_add(1);
+		while (ready.load() != 2) { }
+
+		Jitter   jitter(seed * 2 + 1);
+		Element  element;
+		uint64_t expected = 0;
+		uint64_t loops    = 0;
+
+		while (expected < options.stress_messages) {
+			if (is_stuck(loops)) {
+				fail("stuck waiting for sequence " + std::to_string(expected));
+				return;
+			}
+
+			jitter();
+
+			bool popped;
+			if (jitter.next(2) == 0) {
+				popped = queue->pop(&element);
+			} else {
+				popped = !queue->is_empty();
+				if (popped) {
+					element = queue->front();
+					popped  = queue->pop(nullptr);
+				}
+			}
+
+			if (!popped) {
+				continue;
+			}
+
+			const uint64_t sequence = _Kind::sequence(element);
+
+			if (!_Kind::is_intact(element)) {
+				fail("torn element at sequence " + std::to_string(expected));
+			} else if (sequence > expected) {
+				fail("lost elements " + std::to_string(expected) + ".." + std::to_string(sequence - 1));
+			} else if (sequence < expected) {
+				fail("duplicate or reordered element " + std::to_string(sequence) + " while expecting " + std::to_string(expected));
+			}
+
+			expected = sequence + 1;
+		}
+
+		if (!queue->is_empty()) {
+			fail("queue not empty after the last element");
+		}
+	});
+
+	std::thread producer([&] {
+		pin_this_thread(producer_cpu);
+		ready.fetch_add(1);
+		while (ready.load() != 2) { }
+
+		Jitter   jitter(seed * 2);
+		uint64_t sequence = 0;
+		uint64_t loops    = 0;
+
+		while (sequence < options.stress_messages && !is_stuck(loops)) {
+			jitter();
+
+			if (jitter.next(8) != 0) {
+				if (queue->push(_Kind::make(sequence))) {
+					sequence++;
+				}
+				continue;
+			}
+
+			// a frame of up to 8 elements, a quarter of which are aborted and resent
+			auto         frame  = queue->begin_frame();
+			const size_t length = 1 + jitter.next(8);
+			uint64_t     staged = sequence;
+
+			while (staged - sequence < length && staged < options.stress_messages && frame.push(_Kind::make(staged))) {
+				staged++;
+				jitter();
+			}
+
+			if (jitter.next(4) == 0) {
+				frame.abort();
+			} else {
+				frame.commit();
+				sequence = staged;
+			}
+		}
+	});
+
+	producer.join();
+	consumer.join();
+
+	return report;
+}
+
+using StressRun = RunReport (*)(const Options&, uint64_t, int, int);
+
+/// Configurations a stress iteration picks from. Small capacities keep the queue wrapping and full
+constexpr StressRun CONFIGS[] = {
+	run_once<SequencedKind, 3>,
+	run_once<SequencedKind, 4>,
+	run_once<SequencedKind, 17>,
+	run_once<SequencedKind, 1024>,
+	run_once<StressMessageKind, 3>,
+	run_once<StressMessageKind, 64>,
+};
+
+constexpr const char* CONFIG_NAMES[] = {
+	"sequenced/3",
+	"sequenced/4",
+	"sequenced/17",
+	"sequenced/1024",
+	"Message/3",
+	"Message/64",
+};
+} // namespace
+
+bool run_stress(const Options& options) {
+	const std::vector<int> cpus = allowed_cpus();
+	std::mt19937_64        rng(options.seed);
+	uint64_t               failed_iterations = 0;
+
+	// a single iteration still draws every earlier one, so that it gets the same seed, config and CPUs as in the full run
+	const bool   replay     = options.stress_iteration != SIZE_MAX;
+	const size_t iterations = replay ? options.stress_iteration + 1 : options.iterations;
+
+	for (size_t i = 0; i < iterations; i++) {
+		const uint64_t seed   = rng();
+		const size_t   config = static_cast<size_t>(rng() % std::size(CONFIGS));
+
+		// honour explicit pinning, otherwise pick a random placement, which may share a CPU
+		const int producer_cpu = options.producer_cpu >= 0 ? options.producer_cpu : cpus[rng() % cpus.size()];
+		const int consumer_cpu = options.consumer_cpu >= 0 ? options.consumer_cpu : cpus[rng() % cpus.size()];
+
+		if (replay && i != options.stress_iteration) {
+			continue;
+		}
+
+		const RunReport report = CONFIGS[config](options, seed, producer_cpu, consumer_cpu);
+
+		if (report.errors == 0) {
+			continue;
+		}
+
+		failed_iterations++;
+
+		// the same --seed and iteration, with the same pinning and message count, run exactly this iteration again
+		const std::string replay_args = "--seed " + std::to_string(options.seed)
+			+ " --stress-iteration " + std::to_string(i)
+			+ " --stress-messages " + std::to_string(options.stress_messages)
+			+ (options.producer_cpu >= 0 ? " --producer-cpu " + std::to_string(options.producer_cpu) : "")
+			+ (options.consumer_cpu >= 0 ? " --consumer-cpu " + std::to_string(options.consumer_cpu) : "")
+			+ " stress";
+
+		Result("stress_failure")
+			.add("iteration", static_cast<uint64_t>(i))
+			.add("seed", options.seed)
+			.add("config", CONFIG_NAMES[config])
+			.add("producer_cpu", producer_cpu)
+			.add("consumer_cpu", consumer_cpu)
+			.add("errors", report.errors)
+			.add("first_error", report.first_error)
+			.add("replay", replay_args)
+			.print();
+	}
+
+	Result("stress")
+		.add("iterations", static_cast<uint64_t>(replay ? 1 : iterations))
+		.add("messages_per_iteration", static_cast<uint64_t>(options.stress_messages))
+		.add("seed", options.seed)
+		.add("cpus", static_cast<uint64_t>(cpus.size()))
+		.add("failed_iterations", failed_iterations)
+		.add("valid", failed_iterations == 0 ? "true" : "false")
+		.print();
+
+	return failed_iterations == 0;
+}
+} // namespace lfmq::bench
@@ -0,0 +1,113 @@
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "baselines.hpp"
+#include "bench_common.hpp"
+#include "perf_counters.hpp"
+#include "lfmq/lock_free_queue.hpp"
+
+namespace lfmq::bench
+{
+namespace
+{
+/*
+ * One producer pushes options.messages elements as fast as it can while one
+ * consumer pops them. The clock starts when both threads are running and
+ * stops when the consumer has popped the last element.
+ */
+template<typename _Queue, typename _Kind, size_t _capacity>
+bool run_one(const Options& options) {
+	using Element = typename _Kind::type;
+
+	auto                queue = std::make_unique<typename _Queue::template type<Element, _capacity>>();
+	std::atomic<int>    ready = 0;
+	std::atomic<bool>   start = false;
+	uint64_t            checksum = 0;
+	uint64_t            end_ns   = 0;
+	PerfCounters        counters(options.perf_counters);
+
+	counters.start();
+
+	std::thread consumer([&] {
+		pin_this_thread(options.consumer_cpu);
+		ready.fetch_add(1);
+		while (!start.load()) { }
+
+		Element element;
+		Backoff backoff;
+
+		for (size_t i = 0; i < options.messages; i++) {
+			while (!queue->pop(&element)) {
+				backoff.pause();
+			}
+			backoff.reset();
+
+			checksum += _Kind::sequence(element);
+		}
+
+		end_ns = now_ns();
+	});
+
+	uint64_t start_ns = 0;
+
+	std::thread producer([&] {
+		pin_this_thread(options.producer_cpu);
+		ready.fetch_add(1);
+		while (ready.load() != 2) { }
+
+		Backoff backoff;
+
+		start_ns = now_ns();
+		start.store(true);
+
+		for (size_t i = 0; i < options.messages; i++) {
+			const Element element = _Kind::make(i);
+
+			while (!queue->push(element)) {
+				backoff.pause();
+			}
+			backoff.reset();
+		}
+	});
+
+	producer.join();
+	consumer.join();
+
+	counters.stop();
+
+	const uint64_t n          = options.messages;
+	const uint64_t elapsed_ns = end_ns - start_ns;
+	const bool     valid      = checksum == (n > 0 ? n * (n - 1) / 2 : 0);
+
+	Result result("throughput");
+	result.add("queue", _Queue::name)
+		.add("element", _Kind::name)
+		.add("element_size", static_cast<uint64_t>(sizeof(Element)))
+		.add("payload_size", static_cast<uint64_t>(_Kind::payload_size))
+		.add("capacity", static_cast<uint64_t>(_capacity))
+		.add("messages", n)
+		.add("elapsed_ns", elapsed_ns)
+		.add("msgs_per_sec", elapsed_ns > 0 ? static_cast<double>(n) * 1e9 / static_cast<double>(elapsed_ns) : 0.0)
+		.add("ns_per_msg", n > 0 ? static_cast<double>(elapsed_ns) / static_cast<double>(n) : 0.0)
+		.add("valid", valid ? "true" : "false");
+	add_storage_to(result, *queue);
+	counters.add_to(result, n);
+	result.print();
+
+	return valid;
+}
+} // namespace
+
+bool run_throughput(const Options& options) {
+	bool valid = true;
+
+	for_each_config([&]<typename _Kind, size_t _capacity>() {
+		for_each_queue(options, [&]<typename _Queue>() {
+			valid = run_one<_Queue, _Kind, _capacity>(options) && valid;
+		});
+	});
+
+	return valid;
+}
+} // namespace lfmq::bench
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+namespace lfmq
+{
+/*
+ * Size in bytes that data written by different threads is aligned to so that
+ * it never shares a cache line. std::hardware_destructive_interference_size
+ * is not used since its value can change between compiler flags, which would
+ * change the layout of the types below across translation units.
+ */
+inline constexpr size_t CACHE_LINE_SIZE = 64;
+} // namespace lfmq
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "cache_line.hpp"
+#include "lock_free_queue.hpp"
+#include "message.hpp"
+
+namespace lfmq
+{
+/*
+ * Producer side of an SpscQueue. Only exposes the operations the producer
+ * thread may call, so popping through it does not compile.
+ */
+template <typename _Queue>
+class QueueProducer {
+public:
+	using value_type = typename _Queue::value_type;
+	using frame_type = typename _Queue::Frame;
+
+	/**
+	 * @param queue Queue to push onto. Must outlive the endpoint
+	 */
+	explicit QueueProducer(_Queue& queue) noexcept :
+			queue(&queue)
+	{ }
+
+	QueueProducer(const QueueProducer&) = delete;
+	QueueProducer& operator=(const QueueProducer&) = delete;
+	QueueProducer(QueueProducer&&) noexcept = default;
+	QueueProducer& operator=(QueueProducer&&) noexcept = default;
+
+	/**
+	 * @brief Insert an element onto the queue
+	 * @param element Element to be inserted onto the queue
+	 * @return Whether the element was successfully inserted onto the queue
+	 */
+	bool push(const value_type& element) {
+		return this->queue->push(element);
+	}
+	/**
+	 * @brief Insert an element onto the queue
+	 * @param element Element to be inserted onto the queue
+	 * @return Whether the element was successfully inserted onto the queue
+	 */
+	bool push(value_type&& element) noexcept {
+		return this->queue->push(std::move(element));
+	}
+
+	/**
+	 * @brief Start a frame of elements that become visible to the consumer all at once
+	 * @note Do not call push while the frame is open
+	 * @return Frame to push the elements onto
+	 */
+	frame_type begin_frame() noexcept {
+		return this->queue->begin_frame();
+	}
+
+	/**
+	 * @brief Return the max size of the queue
+	 * @return Max size of the queue
+	 */
+	constexpr size_t capacity() const noexcept {
+		return this->queue->capacity();
+	}
+
+private:
+	_Queue* queue;
+};
+
+/*
+ * Consumer side of an SpscQueue. Only exposes the operations the consumer
+ * thread may call, so pushing through it does not compile.
+ */
+template <typename _Queue>
+class QueueConsumer {
+public:
+	using value_type = typename _Queue::value_type;
+
+	/**
+	 * @param queue Queue to pop from. Must outlive the endpoint
+	 */
+	explicit QueueConsumer(_Queue& queue) noexcept :
+			queue(&queue)
+	{ }
+
+	QueueConsumer(const QueueConsumer&) = delete;
+	QueueConsumer& operator=(const QueueConsumer&) = delete;
+	QueueConsumer(QueueConsumer&&) noexcept = default;
+	QueueConsumer& operator=(QueueConsumer&&) noexcept = default;
+
+	/**
+	 * @brief Remove the oldest element from the queue
+	 * @param element Pointer to assign value of the element at the front to. nullptr if retrieving the element is not desired. Will not be modified if pop returns false
+	 * @return True if the queue has elements and value was popped, false if the queue is empty
+	 */
+	bool pop(value_type* const element = nullptr) {
+		return this->queue->pop(element);
+	}
+
+	/**
+	 * @brief Return a reference to the element at the start of the queue
+	 * @return Reference to the element at the start of the queue
+	 */
+	value_type& front() noexcept {
+		return this->queue->front();
+	}
+
+	/**
+	 * @brief Return whether the queue is empty
+	 * @return Whether the queue is empty
+	 */
+	bool is_empty() const noexcept {
+		return this->queue->is_empty();
+	}
+
+	/**
+	 * @brief Return the max size of the queue
+	 * @return Max size of the queue
+	 */
+	constexpr size_t capacity() const noexcept {
+		return this->queue->capacity();
+	}
+
+private:
+	// drains the queue itself, so that it does not depend on the endpoint staying where it is
+	template <size_t _max_queues, typename _Clock> requires (_max_queues > 0)
+	friend class CommandProcessor;
+
+	_Queue* queue;
+};
+
+/*
+ * The pair of queues every deployment wires between a controller thread and
+ * the audio thread: commands go down to the audio thread, and acks, meters
+ * and garbage come back up. Both rings live in the one Channel object, each
+ * starting on a cache line of its own so that traffic in one direction never
+ * shares a line with the other, and create makes that a single aligned
+ * allocation.
+ *
+ * Each side gets its endpoints from controller or audio. An endpoint only
+ * exposes the operations of its side of its queue, so pushing from the wrong
+ * side is a compile error rather than a data race. Hand each set of
+ * endpoints to a single thread, once.
+ */
+template <typename _Down = Message, typename _Up = _Down, size_t _down_size = 1024, size_t _up_size = _down_size, typename _Traits = DefaultQueueTraits>
+class Channel {
+public:
+	using down_queue_type = SpscQueue<_Down, _down_size, _Traits>;
+	using up_queue_type   = SpscQueue<_Up, _up_size, _Traits>;
+
+	/*
+	 * Endpoints of the controller thread
+	 */
+	struct ControllerEnd {
+		QueueProducer<down_queue_type> to_audio;
+		QueueConsumer<up_queue_type>   from_audio;
+	};
+
+	/*
+	 * Endpoints of the audio thread
+	 */
+	struct AudioEnd {
+		QueueConsumer<down_queue_type> from_controller;
+		QueueProducer<up_queue_type>   to_controller;
+	};
+
+	Channel() = default;
+	Channel(const Channel&) = delete;
+	Channel& operator=(const Channel&) = delete;
+
+	/**
+	 * @brief Allocate a channel. Both rings are usually too large for the stack
+	 * @return Channel holding both rings in a single cache line aligned allocation
+	 */
+	static std::unique_ptr<Channel> create() {
+		return std::make_unique<Channel>();
+	}
+
+	/**
+	 * @brief Return the endpoints of the controller thread
+	 * @return Producer of the down queue and consumer of the up queue
+	 */
+	ControllerEnd controller() noexcept {
+		return ControllerEnd{ QueueProducer<down_queue_type>(this->down), QueueConsumer<up_queue_type>(this->up) };
+	}
+
+	/**
+	 * @brief Return the endpoints of the audio thread
+	 * @return Consumer of the down queue and producer of the up queue
+	 */
+	AudioEnd audio() noexcept {
+		return AudioEnd{ QueueConsumer<down_queue_type>(this->down), QueueProducer<up_queue_type>(this->up) };
+	}
+
+	/**
+	 * @brief Return the queue from the controller to the audio thread, for stats and latency
+	 * @return Queue from the controller to the audio thread
+	 */
+	const down_queue_type& down_queue() const noexcept {
+		return this->down;
+	}
+
+	/**
+	 * @brief Return the queue from the audio thread to the controller, for stats and latency
+	 * @return Queue from the audio thread to the controller
+	 */
+	const up_queue_type& up_queue() const noexcept {
+		return this->up;
+	}
+
+private:
+	alignas(CACHE_LINE_SIZE) down_queue_type down;
+	alignas(CACHE_LINE_SIZE) up_queue_type   up;
+};
+} // namespace lfmq
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace lfmq
+{
+/*
+ * Clocks used to timestamp and budget work on the real-time path. Both
+ * return a raw tick count from now() so that reading them is as cheap as
+ * possible; convert ticks with ticks_per_second() off the real-time path.
+ */
+
+/// std::chrono::steady_clock in nanoseconds
+struct SteadyClock {
+	static uint64_t now() noexcept {
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	static double ticks_per_second() noexcept {
+		return 1e9;
+	}
+};
+
+/// Time stamp counter. Falls back to SteadyClock on architectures without one
+struct TscClock {
+#if defined(__x86_64__) || defined(__i386__)
+	static constexpr bool is_tsc = true;
+
+	static uint64_t now() noexcept {
+		return __rdtsc();
+	}
+
+	/**
+	 * @brief Return the measured frequency of the time stamp counter
+	 * @note The first call calibrates the counter against steady_clock, which blocks for a few milliseconds. Never make the first call from a real-time thread
+	 * @return Frequency of the time stamp counter in ticks per second
+	 */
+	static double ticks_per_second() noexcept;
+#else
+	static constexpr bool is_tsc = false;
+
+	static uint64_t now() noexcept {
+		return SteadyClock::now();
+	}
+
+	static double ticks_per_second() noexcept {
+		return SteadyClock::ticks_per_second();
+	}
+#endif
+};
+} // namespace lfmq
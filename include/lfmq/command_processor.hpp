@@ -0,0 +1,210 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include "channel.hpp"
+#include "clock.hpp"
+#include "lock_free_queue.hpp"
+#include "message.hpp"
+#include "trace.hpp"
+
+namespace lfmq
+{
+/*
+ * Per-call limits of a CommandProcessor. process stops before handling
+ * another message once either limit is reached and leaves the rest in their
+ * queues for the next call.
+ */
+struct CommandBudget {
+	size_t   max_messages = SIZE_MAX;   // Messages handled per call to process
+	uint64_t max_ticks    = UINT64_MAX; // Clock ticks spent per call to process
+};
+
+/*
+ * Outcome of one call to CommandProcessor::process
+ */
+struct ProcessResult {
+	size_t   handled   = 0;     // Messages dispatched, including the ones without a handler
+	uint64_t ticks     = 0;     // Clock ticks the call took
+	bool     exhausted = false; // Whether the call stopped because of the budget, so messages may be left over
+};
+
+/*
+ * The command processor lives on the consumer (audio) thread and replaces
+ * the hand written drain loop of every SpscQueue<Message, N>. It drains up
+ * to _max_queues queues and hands every message to the handler registered
+ * for its MessageType. Handlers are plain function pointers with a context
+ * pointer, kept in a table indexed by message type, so dispatching is an
+ * array load and an indirect call.
+ *
+ * Queues are served round robin one message at a time, so a burst on one
+ * queue cannot starve the others, and a call that runs out of budget resumes
+ * with the queue after the last one it served. The time budget is checked
+ * with _Clock before every message, so a call overruns it by at most the
+ * cost of one handler.
+ */
+template <size_t _max_queues = 4, typename _Clock = TscClock> requires (_max_queues > 0)
+class CommandProcessor {
+public:
+	/// Handler of a message type, called with the context it was registered with
+	using Handler = void (*)(void* context, const Message& message);
+
+	/**
+	 * @brief Register the handler of a message type, replacing the previous one
+	 * @note Not thread safe, register every handler before the consumer thread starts calling process
+	 * @param type Message type to be handled
+	 * @param handler Function called with every message of type. nullptr hands the type to the default handler again
+	 * @param context Pointer passed to handler
+	 */
+	void set_handler(const MessageType type, const Handler handler, void* const context = nullptr) noexcept {
+		const size_t index = static_cast<size_t>(type);
+
+		if (index < MESSAGE_TYPE_COUNT) {
+			this->handlers[index] = Binding{ handler, context };
+		}
+	}
+
+	/**
+	 * @brief Register the handler of every message type that has none. By default such messages are dropped
+	 * @param handler Function called with every message that has no handler of its own. nullptr drops them
+	 * @param context Pointer passed to handler
+	 */
+	void set_default_handler(const Handler handler, void* const context = nullptr) noexcept {
+		this->default_handler = Binding{ handler != nullptr ? handler : ignore, context };
+	}
+
+	/**
+	 * @brief Add a queue to the ones drained by process
+	 * @note process becomes the consumer of queue, so nothing else may pop from it. The queue must outlive the processor
+	 * @param queue Queue to be drained
+	 * @return Whether the queue was added, false if the processor already drains _max_queues queues
+	 */
+	template<size_t _size, typename _Traits>
+	bool add_queue(SpscQueue<Message, _size, _Traits>& queue) noexcept {
+		if (this->source_count == _max_queues) {
+			return false;
+		}
+
+		this->sources[this->source_count++] = Source{ &queue, [](void* const queue, Message* const message) {
+			return static_cast<SpscQueue<Message, _size, _Traits>*>(queue)->pop(message);
+		} };
+
+		return true;
+	}
+
+	/**
+	 * @brief Add the queue of a consumer endpoint, such as Channel::AudioEnd::from_controller, to the ones drained by process
+	 * @note process becomes the consumer of the queue, so nothing else may pop from it. The queue must outlive the processor, the endpoint may be moved or destroyed
+	 * @param consumer Consumer endpoint of the queue to be drained
+	 * @return Whether the queue was added, false if the processor already drains _max_queues queues
+	 */
+	template<size_t _size, typename _Traits>
+	bool add_queue(const QueueConsumer<SpscQueue<Message, _size, _Traits>>& consumer) noexcept {
+		return this->add_queue(*consumer.queue);
+	}
+
+	/**
+	 * @brief Set the limits of every following call to process
+	 * @param budget Limits of a call to process
+	 */
+	void set_budget(const CommandBudget& budget) noexcept {
+		this->budget = budget;
+	}
+
+	const CommandBudget& get_budget() const noexcept {
+		return this->budget;
+	}
+
+	/**
+	 * @brief Convert a duration to the ticks of _Clock, for CommandBudget::max_ticks
+	 * @note The first conversion may calibrate _Clock, never call this from a real-time thread
+	 * @param duration Duration to be converted
+	 * @return Number of ticks of _Clock in duration
+	 */
+	static uint64_t ticks_for(const std::chrono::nanoseconds duration) noexcept {
+		return static_cast<uint64_t>(static_cast<double>(duration.count()) * _Clock::ticks_per_second() / 1e9);
+	}
+
+	/**
+	 * @brief Dispatch messages from every queue until they are all empty or the budget runs out
+	 * @note Only call this from the consumer thread of the queues
+	 * @return Number of messages handled, time taken and whether the budget ran out
+	 */
+	ProcessResult process() {
+		const uint64_t start = _Clock::now();
+		ProcessResult  result;
+
+		// number of queues in a row that turned out empty
+		size_t empty = 0;
+
+		while (empty < this->source_count) {
+			if (result.handled >= this->budget.max_messages || _Clock::now() - start >= this->budget.max_ticks) {
+				result.exhausted = true;
+				break;
+			}
+
+			const size_t  index  = this->next_source;
+			const Source& source = this->sources[index];
+			this->next_source = index + 1 == this->source_count ? 0 : index + 1;
+
+			if (!source.pop(source.queue, &this->message)) {
+				empty++;
+				continue;
+			}
+
+			empty = 0;
+			this->dispatch(static_cast<uint32_t>(index));
+			result.handled++;
+		}
+
+		result.ticks = _Clock::now() - start;
+
+		return result;
+	}
+
+	/**
+	 * @brief Return the number of queues drained by process
+	 * @return Number of queues drained by process
+	 */
+	size_t queue_count() const noexcept {
+		return this->source_count;
+	}
+
+private:
+	struct Binding {
+		Handler handler = nullptr;
+		void*   context = nullptr;
+	};
+
+	struct Source {
+		void* queue = nullptr;
+		bool (*pop)(void* queue, Message* message) = nullptr;
+	};
+
+	static void ignore(void*, const Message&) noexcept { }
+
+	/**
+	 * @brief Hand the message that was just popped to its handler
+	 * @param source Index of the queue it came from, which the trace event is tagged with
+	 */
+	void dispatch(const uint32_t source) {
+		const size_t type = static_cast<size_t>(this->message.get_metadata().get_type());
+
+		const Binding& binding = type < MESSAGE_TYPE_COUNT && this->handlers[type].handler != nullptr ? this->handlers[type] : this->default_handler;
+
+		trace_event(TraceEventKind::DISPATCH, source, element_message_type(this->message));
+		binding.handler(binding.context, this->message);
+	}
+
+	Binding       handlers[MESSAGE_TYPE_COUNT];
+	Binding       default_handler{ ignore, nullptr };
+	Source        sources[_max_queues];
+	size_t        source_count = 0;
+	size_t        next_source  = 0;
+	CommandBudget budget;
+	// popped into here rather than onto the stack, since a Message carries its whole payload buffer
+	Message       message;
+};
+} // namespace lfmq
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "cache_line.hpp"
+#include "message.hpp"
+
+namespace lfmq
+{
+/*
+ * Handle to a pending request. The correlation id is copied into the
+ * metadata of the request message so that the audio thread can complete it.
+ */
+class Ticket {
+private:
+	uint32_t correlation_id;
+
+public:
+	constexpr Ticket() noexcept :
+			correlation_id(MessageMetadata::NO_CORRELATION_ID)
+	{ }
+
+	constexpr explicit Ticket(const uint32_t correlation_id) noexcept :
+			correlation_id(correlation_id)
+	{ }
+
+	constexpr uint32_t get_correlation_id() const noexcept {
+		return this->correlation_id;
+	}
+
+	constexpr bool is_valid() const noexcept {
+		return this->correlation_id != MessageMetadata::NO_CORRELATION_ID;
+	}
+};
+
+/*
+ * The completion table pairs requests sent over an SpscQueue with their
+ * responses. The controller acquires a ticket, stamps its correlation id on
+ * the request message and pushes it. Once the audio thread has applied the
+ * message it completes the correlation id, which is a single wait-free
+ * compare-and-swap on a preallocated slot. The controller then either polls
+ * the ticket or blocks on it with std::atomic::wait, and finally releases it
+ * so that the slot can be reused.
+ *
+ * A correlation id encodes the index of its slot along with the generation
+ * of the slot, so completing a ticket that was already released is detected
+ * and ignored rather than completing whoever reused the slot.
+ */
+template <size_t _slots> requires (_slots > 0 && _slots <= UINT32_MAX / 2)
+class CompletionTable {
+public:
+	CompletionTable() = default;
+	CompletionTable(const CompletionTable&) = delete;
+	CompletionTable& operator=(const CompletionTable&) = delete;
+
+	/**
+	 * @brief Reserve a slot for a new request
+	 * @note Lock-free. May be called from any number of non real-time threads
+	 * @param ticket Ticket to assign the reserved slot to. Will not be modified if acquire returns false
+	 * @return True if a slot was reserved, false if every slot is in use
+	 */
+	bool acquire(Ticket& ticket) noexcept {
+		const size_t start = this->next_slot.fetch_add(1, std::memory_order_relaxed);
+
+		for (size_t i = 0; i < _slots; i++) {
+			const size_t index = (start + i) % _slots;
+			Slot&        slot  = this->slots[index];
+			uint64_t     state = slot.state.load(std::memory_order_relaxed);
+
+			if (phase_of(state) != FREE) {
+				continue;
+			}
+
+			const uint32_t correlation_id = next_correlation_id(id_of(state), index);
+			if (slot.state.compare_exchange_strong(state, make_state(correlation_id, PENDING), std::memory_order_acquire, std::memory_order_relaxed)) {
+				ticket = Ticket(correlation_id);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * @brief Mark the request with correlation_id as applied. Wait-free
+	 * @note Meant to be called from the audio thread
+	 * @param correlation_id Correlation id taken from the request message
+	 * @param result Value handed back to the controller
+	 * @return True if the request was completed, false if correlation_id is not pending (already completed, released or invalid)
+	 */
+	bool complete(const uint32_t correlation_id, const int64_t result = 0) noexcept {
+		if (correlation_id == MessageMetadata::NO_CORRELATION_ID) {
+			return false;
+		}
+
+		Slot&    slot     = this->slots[index_of(correlation_id)];
+		uint64_t expected = make_state(correlation_id, PENDING);
+
+		// claim the slot first so that a stale completion can never overwrite another request's result
+		if (!slot.state.compare_exchange_strong(expected, make_state(correlation_id, COMPLETING), std::memory_order_acquire, std::memory_order_relaxed)) {
+			return false;
+		}
+
+		slot.result = result;
+		slot.state.store(make_state(correlation_id, COMPLETE), std::memory_order_release);
+		// only issues a futex wake if the controller is blocked on this slot
+		slot.state.notify_all();
+
+		return true;
+	}
+
+	/**
+	 * @brief Mark the request as applied. Wait-free
+	 * @note Meant to be called from the audio thread
+	 * @param message Request message carrying the correlation id
+	 * @param result Value handed back to the controller
+	 * @return True if the request was completed, false if the message does not carry a pending correlation id
+	 */
+	bool complete(const Message& message, const int64_t result = 0) noexcept {
+		return this->complete(message.get_metadata().get_correlation_id(), result);
+	}
+
+	/**
+	 * @brief Check whether the request has been completed without blocking
+	 * @param ticket Ticket returned by acquire
+	 * @param result Pointer to assign the result of the request to. nullptr if the result is not desired. Will not be modified if poll returns false
+	 * @return Whether the request has been completed
+	 */
+	bool poll(const Ticket& ticket, int64_t* const result = nullptr) const noexcept {
+		const Slot& slot = this->slots[index_of(ticket.get_correlation_id())];
+
+		if (slot.state.load(std::memory_order_acquire) != make_state(ticket.get_correlation_id(), COMPLETE)) {
+			return false;
+		}
+
+		if (result != nullptr) {
+			*result = slot.result;
+		}
+
+		return true;
+	}
+
+	/**
+	 * @brief Block until the request has been completed
+	 * @note Never call this from a real-time thread
+	 * @param ticket Ticket returned by acquire and not released yet
+	 * @return Result of the request
+	 */
+	int64_t wait(const Ticket& ticket) const noexcept {
+		const Slot&    slot     = this->slots[index_of(ticket.get_correlation_id())];
+		const uint64_t complete = make_state(ticket.get_correlation_id(), COMPLETE);
+		uint64_t       state    = slot.state.load(std::memory_order_acquire);
+
+		while (state != complete) {
+			slot.state.wait(state, std::memory_order_acquire);
+			state = slot.state.load(std::memory_order_acquire);
+		}
+
+		return slot.result;
+	}
+
+	/**
+	 * @brief Give the slot of the ticket back to the table. A pending request is cancelled, and completing it later has no effect
+	 * @param ticket Ticket returned by acquire. Invalidated by this call
+	 */
+	void release(Ticket& ticket) noexcept {
+		const uint32_t correlation_id = ticket.get_correlation_id();
+		Slot&          slot           = this->slots[index_of(correlation_id)];
+		uint64_t       state          = slot.state.load(std::memory_order_relaxed);
+
+		while (id_of(state) == correlation_id && phase_of(state) != FREE) {
+			// a completion in progress only has a couple of stores left to do
+			if (phase_of(state) == COMPLETING) {
+				state = slot.state.load(std::memory_order_relaxed);
+				continue;
+			}
+
+			if (slot.state.compare_exchange_weak(state, make_state(correlation_id, FREE), std::memory_order_release, std::memory_order_relaxed)) {
+				break;
+			}
+		}
+
+		ticket = Ticket();
+	}
+
+	/**
+	 * @brief Return the max number of requests that can be pending at once
+	 * @return Max number of requests that can be pending at once
+	 */
+	constexpr size_t capacity() const noexcept {
+		return _slots;
+	}
+
+private:
+	enum Phase : uint64_t {
+		FREE       = 0,
+		PENDING    = 1,
+		COMPLETING = 2,
+		COMPLETE   = 3
+	};
+
+	/// Number of generations a slot cycles through before its correlation ids repeat
+	static constexpr uint32_t GENERATIONS = UINT32_MAX / _slots;
+
+	struct alignas(CACHE_LINE_SIZE) Slot {
+		/// Correlation id of the current or last request in the upper bits, Phase in the lower 2 bits
+		std::atomic<uint64_t> state  = 0;
+		int64_t               result = 0;
+	};
+
+	static constexpr uint64_t make_state(const uint32_t correlation_id, const Phase phase) noexcept {
+		return (static_cast<uint64_t>(correlation_id) << 2) | phase;
+	}
+
+	static constexpr uint32_t id_of(const uint64_t state) noexcept {
+		return static_cast<uint32_t>(state >> 2);
+	}
+
+	static constexpr Phase phase_of(const uint64_t state) noexcept {
+		return static_cast<Phase>(state & 3);
+	}
+
+	static constexpr size_t index_of(const uint32_t correlation_id) noexcept {
+		return correlation_id % _slots;
+	}
+
+	/**
+	 * @brief Return the correlation id of the next request in slot index
+	 * @param last_correlation_id Correlation id of the previous request in the slot, NO_CORRELATION_ID if there was none
+	 * @param index Index of the slot
+	 * @return Correlation id of the next request, never NO_CORRELATION_ID
+	 */
+	static constexpr uint32_t next_correlation_id(const uint32_t last_correlation_id, const size_t index) noexcept {
+		// generations start at 1 so that a correlation id is never 0
+		uint32_t generation = last_correlation_id / _slots + 1;
+
+		if (generation >= GENERATIONS) {
+			generation = 1;
+		}
+
+		return static_cast<uint32_t>(generation * _slots + index);
+	}
+
+	Slot                slots[_slots];
+	std::atomic<size_t> next_slot = 0;
+};
+} // namespace lfmq
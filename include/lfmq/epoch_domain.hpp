@@ -0,0 +1,316 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "cache_line.hpp"
+#include "queue_policies.hpp"
+
+namespace lfmq
+{
+/*
+ * Epoch-based reclamation of objects shared by reader threads and a single
+ * reclaimer thread, for pointer-carrying messages and node-based structures
+ * where a reader may still dereference an object after it was unlinked.
+ * Readers wrap every access in a critical section; the reclaimer unlinks an
+ * object, retires it, and frees retired objects in batches from collect.
+ *
+ * A reader entering a critical section announces the global epoch it saw in
+ * its own slot, and clears the slot when it leaves. The reclaimer moves the
+ * global epoch forward only once every reader that is inside a critical
+ * section has announced the current epoch, and frees an object retired in
+ * epoch e once the global epoch reached e + 2: by then every critical section
+ * that could have seen the object has ended. Entering costs an acquire load
+ * of the global epoch and a seq_cst store to the reader's own cache line,
+ * leaving a release store, and neither ever waits.
+ *
+ * The seq_cst announcement pairs with the seq_cst scan of collect; that is
+ * what guarantees the reclaimer either sees the reader inside its critical
+ * section or that the reader sees the object unlinked. Shared pointers must
+ * therefore be unlinked and loaded with seq_cst as well. A reader that stays
+ * inside a critical section holds back every object retired after it entered.
+ * The bench "model" scenario checks the grace period against a reader.
+ *
+ * Only the atomic_type of _Traits is used, so model::ModelQueueTraits runs
+ * the domain under the model checker.
+ */
+template <size_t _max_readers = 8, typename _Traits = DefaultQueueTraits> requires (_max_readers > 0)
+class EpochDomain {
+	struct Slot;
+
+public:
+	using Deleter = void (*)(void*);
+
+	/*
+	 * Registration of one reader thread with the domain. Obtained from
+	 * register_reader and only used by the thread it was handed to. Critical
+	 * sections of the same reader may nest.
+	 */
+	class Reader {
+	public:
+		Reader() = default;
+		Reader(const Reader&) = delete;
+		Reader& operator=(const Reader&) = delete;
+
+		/**
+		 * @brief Give the slot back to the domain
+		 */
+		~Reader() {
+			this->release();
+		}
+
+		/**
+		 * @brief Enter a critical section. Objects loaded from now on stay valid until the matching exit
+		 * @note Only call this from the reader thread. Wait-free
+		 */
+		void enter() noexcept {
+			if (this->depth++ == 0) {
+				// acquire so that the reader never announces an epoch from after an object it can still reach was unlinked
+				this->slot->epoch.store(this->domain->global_epoch.load(std::memory_order_acquire), std::memory_order_seq_cst);
+			}
+		}
+
+		/**
+		 * @brief Leave the critical section entered by the matching enter
+		 * @note Only call this from the reader thread. Wait-free
+		 */
+		void exit() noexcept {
+			if (--this->depth == 0) {
+				// release so that every access made inside the section happens before the object is freed
+				this->slot->epoch.store(QUIESCENT, std::memory_order_release);
+			}
+		}
+
+		/**
+		 * @brief Return whether the reader is inside a critical section
+		 * @return Whether the reader is inside a critical section
+		 */
+		bool is_active() const noexcept {
+			return this->depth != 0;
+		}
+
+		/**
+		 * @brief Return whether the reader holds a slot of a domain
+		 * @return Whether the reader holds a slot of a domain
+		 */
+		bool is_registered() const noexcept {
+			return this->slot != nullptr;
+		}
+
+		/**
+		 * @brief Give the slot back to the domain. Must not be inside a critical section
+		 */
+		void release() noexcept {
+			if (this->slot != nullptr) {
+				this->slot->registered.store(false, std::memory_order_release);
+				this->slot   = nullptr;
+				this->domain = nullptr;
+			}
+		}
+
+	private:
+		friend class EpochDomain;
+
+		EpochDomain* domain = nullptr;
+		Slot*        slot   = nullptr;
+		uint32_t     depth  = 0;
+	};
+
+	/*
+	 * Critical section of a reader for the lifetime of the guard
+	 */
+	class Guard {
+	public:
+		explicit Guard(Reader& reader) noexcept :
+				reader(reader)
+		{
+			this->reader.enter();
+		}
+
+		~Guard() {
+			this->reader.exit();
+		}
+
+		Guard(const Guard&) = delete;
+		Guard& operator=(const Guard&) = delete;
+
+	private:
+		Reader& reader;
+	};
+
+	EpochDomain() = default;
+	EpochDomain(const EpochDomain&) = delete;
+	EpochDomain& operator=(const EpochDomain&) = delete;
+
+	/**
+	 * @brief Free every retired object
+	 * @note Only destroy the domain once no reader is inside a critical section
+	 */
+	~EpochDomain() {
+		for (const Retired& retired : this->retired) {
+			retired.deleter(retired.ptr);
+		}
+	}
+
+	/**
+	 * @brief Assign a free slot of the domain to reader
+	 * @note Call this from the reader thread before it starts, or from any thread the reader is handed to afterwards
+	 * @param reader Reader to be registered. Released first if it already holds a slot
+	 * @return True if a slot was assigned, false if _max_readers readers are registered
+	 */
+	bool register_reader(Reader& reader) noexcept {
+		reader.release();
+
+		for (Slot& slot : this->slots) {
+			bool expected = false;
+
+			if (slot.registered.compare_exchange_strong(expected, true, std::memory_order_acquire, std::memory_order_relaxed)) {
+				reader.domain = this;
+				reader.slot   = &slot;
+				reader.depth  = 0;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * @brief Hand ownership of an object that was unlinked from every shared pointer to the domain
+	 * @note Only call this from the reclaimer thread, after the seq_cst store that unlinked ptr
+	 * @param ptr Object to be deleted once no reader can reach it. nullptr is accepted and ignored
+	 */
+	template<typename _T>
+	void retire(_T* const ptr) {
+		this->retire(static_cast<void*>(const_cast<std::remove_cv_t<_T>*>(ptr)), &EpochDomain::delete_object<std::remove_cv_t<_T>>);
+	}
+
+	/**
+	 * @brief Hand ownership of the object held by ptr to the domain
+	 * @note Only call this from the reclaimer thread, after the seq_cst store that unlinked the object
+	 * @param ptr Owner of the object to be deleted once no reader can reach it. Empty after this call
+	 */
+	template<typename _T> requires (!std::is_array_v<_T>)
+	void retire(std::unique_ptr<_T> ptr) {
+		this->retire(ptr.release());
+	}
+
+	/**
+	 * @brief Hand ownership of ptr to the domain along with the function that frees it
+	 * @note Only call this from the reclaimer thread, after the seq_cst store that unlinked ptr
+	 * @param ptr Object to be freed once no reader can reach it. nullptr is accepted and ignored
+	 * @param deleter Function called with ptr on the reclaimer thread
+	 */
+	void retire(void* const ptr, const Deleter deleter) {
+		if (ptr == nullptr) {
+			return;
+		}
+
+		this->retired.push_back(Retired{ ptr, deleter, this->global_epoch.load(std::memory_order_relaxed) });
+	}
+
+	/**
+	 * @brief Move the global epoch forward as far as the readers allow and free every retired object no reader can reach
+	 * @note Only call this from the reclaimer thread, periodically. Frees memory, never call it from a real-time thread
+	 * @return Number of objects freed
+	 */
+	size_t collect() {
+		// two steps are enough for everything retired so far once the readers are quiescent
+		if (this->try_advance()) {
+			this->try_advance();
+		}
+
+		const uint64_t epoch = this->global_epoch.load(std::memory_order_relaxed);
+		size_t         count = 0;
+
+		std::erase_if(this->retired, [&](const Retired& retired) {
+			if (retired.epoch + 2 > epoch) {
+				return false;
+			}
+
+			retired.deleter(retired.ptr);
+			count++;
+
+			return true;
+		});
+
+		return count;
+	}
+
+	/**
+	 * @brief Return the global epoch
+	 * @return Global epoch
+	 */
+	uint64_t epoch() const noexcept {
+		return this->global_epoch.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Return the number of objects waiting for the readers to move past them
+	 * @note Only call this from the reclaimer thread
+	 * @return Number of retired objects that have not been freed
+	 */
+	size_t retired_count() const noexcept {
+		return this->retired.size();
+	}
+
+	/**
+	 * @brief Return the max number of readers registered at once
+	 * @return Max number of readers registered at once
+	 */
+	constexpr size_t max_readers() const noexcept {
+		return _max_readers;
+	}
+
+private:
+	/// Epoch of a slot whose reader is outside of any critical section. The global epoch starts above it
+	static constexpr uint64_t QUIESCENT = 0;
+
+	// written by its reader on every enter and exit, so every slot gets a cache line of its own
+	struct alignas(CACHE_LINE_SIZE) Slot {
+		typename _Traits::template atomic_type<uint64_t> epoch      = QUIESCENT; // Epoch announced by the reader, QUIESCENT outside of critical sections
+		typename _Traits::template atomic_type<bool>     registered = false;     // Whether a Reader holds the slot
+	};
+
+	struct Retired {
+		void*    ptr     = nullptr;
+		Deleter  deleter = nullptr;
+		uint64_t epoch   = 0; // Global epoch when ptr was retired
+	};
+
+	template<typename _T>
+	static void delete_object(void* const ptr) {
+		delete static_cast<_T*>(ptr);
+	}
+
+	/**
+	 * @brief Move the global epoch forward by one if every reader inside a critical section announced the current one
+	 * @return Whether the epoch moved
+	 */
+	bool try_advance() noexcept {
+		const uint64_t epoch = this->global_epoch.load(std::memory_order_relaxed);
+
+		for (const Slot& slot : this->slots) {
+			const uint64_t announced = slot.epoch.load(std::memory_order_seq_cst);
+
+			if (announced != QUIESCENT && announced != epoch) {
+				return false;
+			}
+		}
+
+		this->global_epoch.store(epoch + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	alignas(CACHE_LINE_SIZE) typename _Traits::template atomic_type<uint64_t> global_epoch = QUIESCENT + 1;
+
+	Slot slots[_max_readers];
+
+	std::vector<Retired> retired;
+};
+} // namespace lfmq
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "cache_line.hpp"
+
+namespace lfmq
+{
+/*
+ * Wakes a consumer that waits in epoll, poll or io_uring instead of spinning
+ * on pop, for example a controller thread that serves sockets next to the
+ * queue coming back from the audio thread. The notifier owns an eventfd that
+ * becomes readable when the queue goes from empty to non-empty.
+ *
+ * Only that edge is signalled. The consumer arms the notifier right before
+ * it goes back to waiting, and the first push after that disarms it and
+ * writes to the eventfd, so a burst costs one write no matter how many
+ * elements it holds and a queue that is being drained costs none. Every push
+ * still pays a seq_cst fence and a relaxed load; the fence is what
+ * guarantees the producer either sees the notifier armed or the consumer
+ * sees the element when it checks the queue after arming.
+ *
+ * Producer:
+ *     if (queue.push(element)) notifier.notify();
+ *
+ * Consumer, after fd() was added to an epoll set:
+ *     epoll_wait(...);
+ *     notifier.consume();
+ *     do { while (queue.pop(&element)) handle(element); } while (!notifier.arm(queue));
+ *
+ * The write only happens on the edge, but it is still a system call, so a
+ * real-time producer pays one per burst.
+ *
+ * The model checker does not simulate fences, so it cannot check this
+ * handshake. The notifier scenario of lfmq_bench runs it on real threads
+ * instead and fails if a wakeup is ever lost.
+ */
+class EventNotifier {
+public:
+	EventNotifier() = default;
+	EventNotifier(const EventNotifier&) = delete;
+	EventNotifier& operator=(const EventNotifier&) = delete;
+
+	/**
+	 * @brief Close the eventfd if it is open
+	 */
+	~EventNotifier();
+
+	/**
+	 * @brief Create the eventfd. The notifier starts out armed, as if the consumer was waiting on an empty queue
+	 * @return True if the eventfd was created, false if it could not be or eventfd is not supported on this platform
+	 */
+	bool open();
+
+	/**
+	 * @brief Close the eventfd
+	 * @note Only call this once neither side uses the notifier anymore
+	 */
+	void close();
+
+	/**
+	 * @brief Return the eventfd to wait on for readability, -1 if the notifier is not open
+	 * @return File descriptor of the eventfd
+	 */
+	int fd() const noexcept {
+		return this->event_fd;
+	}
+
+	/**
+	 * @brief Wake the consumer if it armed the notifier. Call this after every successful push or frame commit
+	 * @note Only call this from the producer thread. Makes a system call only on the empty to non-empty edge
+	 */
+	void notify() noexcept {
+		// orders the write index store of the push before the load of armed
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		if (this->armed.load(std::memory_order_relaxed) && this->armed.exchange(false, std::memory_order_relaxed)) {
+			this->signal();
+		}
+	}
+
+	/**
+	 * @brief Arm the notifier before waiting on fd, and check the queue once more
+	 * @note Only call this from the consumer thread, once the queue has been drained
+	 * @param queue Queue the notifier belongs to
+	 * @return True if the consumer may wait on fd, false if an element arrived in the meantime and the queue has to be drained again
+	 */
+	template<typename _Queue>
+	bool arm(const _Queue& queue) noexcept {
+		this->armed.store(true, std::memory_order_relaxed);
+		// orders the store of armed before the load of the write index
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		if (!queue.is_empty()) {
+			this->armed.store(false, std::memory_order_relaxed);
+			return false;
+		}
+
+		return true;
+	}
+
+	/**
+	 * @brief Reset the eventfd after it became readable, so that the next wait blocks until the next edge
+	 * @note Only call this from the consumer thread
+	 */
+	void consume() noexcept;
+
+	/**
+	 * @brief Return the number of times the producer wrote to the eventfd
+	 * @return Number of edges signalled
+	 */
+	uint64_t signal_count() const noexcept {
+		return this->signals.load(std::memory_order_relaxed);
+	}
+
+private:
+	/**
+	 * @brief Write to the eventfd
+	 */
+	void signal() noexcept;
+
+	int event_fd = -1;
+
+	// written by both sides on every edge, so kept away from whatever follows the notifier
+	alignas(CACHE_LINE_SIZE) std::atomic<bool> armed = true;
+	std::atomic<uint64_t>                      signals = 0;
+};
+} // namespace lfmq
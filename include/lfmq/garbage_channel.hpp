@@ -0,0 +1,115 @@
+#pragma once
+
+#include <memory>
+
+#include "lock_free_queue.hpp"
+
+namespace lfmq
+{
+/*
+ * The garbage channel moves ownership of retired objects from a real-time
+ * thread to a reclaimer thread. The real-time thread must never call delete
+ * itself since the allocator may take a lock or unmap pages, so instead it
+ * pushes a type-erased (pointer, deleter) pair onto an SpscQueue. The
+ * reclaimer thread periodically collects the queue and runs the deleters in
+ * a batch.
+ */
+template <size_t _size>
+class GarbageChannel {
+public:
+	using Deleter = void (*)(void*);
+
+	GarbageChannel() = default;
+	GarbageChannel(const GarbageChannel&) = delete;
+	GarbageChannel& operator=(const GarbageChannel&) = delete;
+
+	/**
+	 * @brief Destroy everything that was retired but not collected yet
+	 */
+	~GarbageChannel() {
+		this->collect();
+	}
+
+	/**
+	 * @brief Hand ownership of ptr to the reclaimer thread. Wait-free
+	 * @note Only call this from the retiring (producer) thread
+	 * @param ptr Object to be deleted on the reclaimer thread. nullptr is accepted and ignored
+	 * @return True if ownership was transferred, false if the channel is full. ptr is still owned by the caller if this returns false
+	 */
+	template<typename _T>
+	bool retire(_T* const ptr) noexcept {
+		return this->retire(static_cast<void*>(const_cast<std::remove_cv_t<_T>*>(ptr)), &GarbageChannel::delete_object<std::remove_cv_t<_T>>);
+	}
+
+	/**
+	 * @brief Hand ownership of the object held by ptr to the reclaimer thread. Wait-free
+	 * @note Only call this from the retiring (producer) thread
+	 * @param ptr Owner of the object to be deleted on the reclaimer thread. Left untouched if retire returns false
+	 * @return True if ownership was transferred, false if the channel is full
+	 */
+	template<typename _T> requires (!std::is_array_v<_T>)
+	bool retire(std::unique_ptr<_T>& ptr) noexcept {
+		if (!this->retire(ptr.get())) {
+			return false;
+		}
+
+		(void)ptr.release();
+
+		return true;
+	}
+
+	/**
+	 * @brief Hand ownership of ptr to the reclaimer thread along with the function that frees it. Wait-free
+	 * @note Only call this from the retiring (producer) thread
+	 * @param ptr Object to be freed on the reclaimer thread. nullptr is accepted and ignored
+	 * @param deleter Function called with ptr on the reclaimer thread
+	 * @return True if ownership was transferred, false if the channel is full
+	 */
+	bool retire(void* const ptr, const Deleter deleter) noexcept {
+		if (ptr == nullptr) {
+			return true;
+		}
+
+		return this->retired.push(Retired{ ptr, deleter });
+	}
+
+	/**
+	 * @brief Run the deleters of up to max_count retired objects
+	 * @note Only call this from the reclaimer (consumer) thread
+	 * @param max_count Maximum number of objects to free in this batch
+	 * @return Number of objects that were freed
+	 */
+	size_t collect(const size_t max_count = _size) {
+		Retired garbage;
+		size_t  count = 0;
+
+		while (count < max_count && this->retired.pop(&garbage)) {
+			garbage.deleter(garbage.ptr);
+			count++;
+		}
+
+		return count;
+	}
+
+	/**
+	 * @brief Return the max number of objects that can wait for collection
+	 * @return Max number of objects that can wait for collection
+	 */
+	constexpr size_t capacity() const noexcept {
+		return this->retired.capacity() - 1;
+	}
+
+private:
+	struct Retired {
+		void*   ptr     = nullptr;
+		Deleter deleter = nullptr;
+	};
+
+	template<typename _T>
+	static void delete_object(void* const ptr) {
+		delete static_cast<_T*>(ptr);
+	}
+
+	SpscQueue<Retired, _size> retired;
+};
+} // namespace lfmq
@@ -0,0 +1,345 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "cache_line.hpp"
+#include "lock_free_queue.hpp"
+#include "queue_policies.hpp"
+
+namespace lfmq
+{
+/*
+ * Hazard pointer reclamation of objects shared by reader threads and a
+ * single reclaimer thread. Unlike EpochDomain, a reader that is descheduled
+ * while it holds a pointer only holds back the objects it protects, never
+ * every object retired after it: at most HAZARD_COUNT retired objects
+ * survive a scan.
+ *
+ * A reader protects a pointer by publishing it in one of its _hazards hazard
+ * slots and checking that the source still holds it. The reclaimer frees a
+ * retired object once a scan finds it in no hazard slot. Scans run in
+ * batches, whenever SCAN_THRESHOLD objects are waiting or when the reclaimer
+ * calls scan, so the hazard slots are read once per batch rather than once
+ * per object.
+ *
+ * Readers may retire objects too. These go through an SpscQueue of the
+ * reader's own to the reclaimer, so retiring is wait-free and never frees
+ * anything on the reader thread.
+ *
+ * The seq_cst hazard store pairs with the seq_cst scan; that is what
+ * guarantees the reclaimer either sees the hazard or the reader sees the
+ * object unlinked. Shared pointers must therefore be unlinked with seq_cst.
+ * The bench "model" scenario checks the scan against a reader.
+ *
+ * Only the atomic_type of _Traits is used, so model::ModelQueueTraits runs
+ * the domain under the model checker.
+ */
+template <size_t _max_readers = 4, size_t _hazards = 2, size_t _retire_capacity = 64, typename _Traits = DefaultQueueTraits> requires (_max_readers > 0 && _hazards > 0)
+class HazardDomain {
+	struct Slot;
+
+public:
+	using Deleter = void (*)(void*);
+
+	/// Hazard slots of every reader together, the most retired objects a scan can leave behind
+	static constexpr size_t HAZARD_COUNT = _max_readers * _hazards;
+
+	/// Number of retired objects that triggers a scan from retire
+	static constexpr size_t SCAN_THRESHOLD = 2 * HAZARD_COUNT;
+
+	/*
+	 * Registration of one reader thread with the domain. Obtained from
+	 * register_reader and only used by the thread it was handed to.
+	 */
+	class Reader {
+	public:
+		Reader() = default;
+		Reader(const Reader&) = delete;
+		Reader& operator=(const Reader&) = delete;
+
+		/**
+		 * @brief Clear every hazard and give the slot back to the domain
+		 */
+		~Reader() {
+			this->release();
+		}
+
+		/**
+		 * @brief Make one attempt to protect the pointer held by source with the given hazard
+		 * @note Only call this from the reader thread. Wait-free
+		 * @param hazard Index of the hazard slot, less than _hazards. Replaces what it protected before
+		 * @param source Shared pointer to load from
+		 * @param ptr Pointer to assign the protected object to. Valid until the hazard is cleared or reused. Will not be modified if try_protect returns false
+		 * @return True if the object is protected, false if source changed during the attempt, which leaves the hazard cleared
+		 */
+		template<typename _Atomic>
+		bool try_protect(const size_t hazard, const _Atomic& source, decltype(source.load())& ptr) noexcept {
+			const auto candidate = source.load(std::memory_order_acquire);
+
+			this->slot->hazards[hazard].store(const_cast<void*>(static_cast<const void*>(candidate)), std::memory_order_seq_cst);
+
+			if (source.load(std::memory_order_seq_cst) != candidate) {
+				// so that a failed attempt does not keep the replaced object alive
+				this->clear(hazard);
+				return false;
+			}
+
+			ptr = candidate;
+
+			return true;
+		}
+
+		/**
+		 * @brief Protect the pointer held by source with the given hazard
+		 * @note Only call this from the reader thread. Lock-free: it only retries while source keeps changing
+		 * @param hazard Index of the hazard slot, less than _hazards. Replaces what it protected before
+		 * @param source Shared pointer to load from
+		 * @return Protected pointer, valid until the hazard is cleared or reused
+		 */
+		template<typename _Atomic>
+		auto protect(const size_t hazard, const _Atomic& source) noexcept {
+			decltype(source.load()) ptr = nullptr;
+
+			while (!this->try_protect(hazard, source, ptr)) { }
+
+			return ptr;
+		}
+
+		/**
+		 * @brief Stop protecting the object held by the given hazard
+		 * @note Only call this from the reader thread. Wait-free
+		 * @param hazard Index of the hazard slot, less than _hazards
+		 */
+		void clear(const size_t hazard) noexcept {
+			// release so that every access through the pointer happens before the object is freed
+			this->slot->hazards[hazard].store(nullptr, std::memory_order_release);
+		}
+
+		/**
+		 * @brief Hand ownership of an unlinked object to the reclaimer thread
+		 * @note Only call this from the reader thread. Wait-free
+		 * @param ptr Object to be deleted once no hazard protects it. nullptr is accepted and ignored
+		 * @return True if ownership was transferred, false if the reader's queue is full until the next scan. ptr is still owned by the caller if this returns false
+		 */
+		template<typename _T>
+		bool retire(_T* const ptr) noexcept {
+			return this->retire(static_cast<void*>(const_cast<std::remove_cv_t<_T>*>(ptr)), &HazardDomain::delete_object<std::remove_cv_t<_T>>);
+		}
+
+		/**
+		 * @brief Hand ownership of ptr to the reclaimer thread along with the function that frees it
+		 * @note Only call this from the reader thread. Wait-free
+		 * @param ptr Object to be freed once no hazard protects it. nullptr is accepted and ignored
+		 * @param deleter Function called with ptr on the reclaimer thread
+		 * @return True if ownership was transferred, false if the reader's queue is full until the next scan
+		 */
+		bool retire(void* const ptr, const Deleter deleter) noexcept {
+			if (ptr == nullptr) {
+				return true;
+			}
+
+			return this->slot->retired.push(Retired{ ptr, deleter });
+		}
+
+		/**
+		 * @brief Return whether the reader holds a slot of a domain
+		 * @return Whether the reader holds a slot of a domain
+		 */
+		bool is_registered() const noexcept {
+			return this->slot != nullptr;
+		}
+
+		/**
+		 * @brief Clear every hazard and give the slot back to the domain
+		 */
+		void release() noexcept {
+			if (this->slot == nullptr) {
+				return;
+			}
+
+			for (size_t hazard = 0; hazard < _hazards; hazard++) {
+				this->clear(hazard);
+			}
+
+			this->slot->registered.store(false, std::memory_order_release);
+			this->slot = nullptr;
+		}
+
+	private:
+		friend class HazardDomain;
+
+		Slot* slot = nullptr;
+	};
+
+	HazardDomain() = default;
+	HazardDomain(const HazardDomain&) = delete;
+	HazardDomain& operator=(const HazardDomain&) = delete;
+
+	/**
+	 * @brief Free every retired object
+	 * @note Only destroy the domain once no reader protects anything
+	 */
+	~HazardDomain() {
+		this->drain_readers();
+
+		for (const Retired& retired : this->retired) {
+			retired.deleter(retired.ptr);
+		}
+	}
+
+	/**
+	 * @brief Assign a free slot of the domain to reader
+	 * @note Call this from the reader thread before it starts, or from any thread the reader is handed to afterwards
+	 * @param reader Reader to be registered. Released first if it already holds a slot
+	 * @return True if a slot was assigned, false if _max_readers readers are registered
+	 */
+	bool register_reader(Reader& reader) noexcept {
+		reader.release();
+
+		for (Slot& slot : this->slots) {
+			bool expected = false;
+
+			if (slot.registered.compare_exchange_strong(expected, true, std::memory_order_acquire, std::memory_order_relaxed)) {
+				reader.slot = &slot;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * @brief Hand ownership of an object that was unlinked from every shared pointer to the domain
+	 * @note Only call this from the reclaimer thread, after the seq_cst store that unlinked ptr. Scans once SCAN_THRESHOLD objects are waiting
+	 * @param ptr Object to be deleted once no hazard protects it. nullptr is accepted and ignored
+	 */
+	template<typename _T>
+	void retire(_T* const ptr) {
+		this->retire(static_cast<void*>(const_cast<std::remove_cv_t<_T>*>(ptr)), &HazardDomain::delete_object<std::remove_cv_t<_T>>);
+	}
+
+	/**
+	 * @brief Hand ownership of the object held by ptr to the domain
+	 * @note Only call this from the reclaimer thread, after the seq_cst store that unlinked the object
+	 * @param ptr Owner of the object to be deleted once no hazard protects it. Empty after this call
+	 */
+	template<typename _T> requires (!std::is_array_v<_T>)
+	void retire(std::unique_ptr<_T> ptr) {
+		this->retire(ptr.release());
+	}
+
+	/**
+	 * @brief Hand ownership of ptr to the domain along with the function that frees it
+	 * @note Only call this from the reclaimer thread, after the seq_cst store that unlinked ptr
+	 * @param ptr Object to be freed once no hazard protects it. nullptr is accepted and ignored
+	 * @param deleter Function called with ptr on the reclaimer thread
+	 */
+	void retire(void* const ptr, const Deleter deleter) {
+		if (ptr == nullptr) {
+			return;
+		}
+
+		this->retired.push_back(Retired{ ptr, deleter });
+
+		if (this->retired.size() >= SCAN_THRESHOLD) {
+			this->scan();
+		}
+	}
+
+	/**
+	 * @brief Collect the objects retired by readers and free every retired object no hazard protects
+	 * @note Only call this from the reclaimer thread, periodically. Frees memory, never call it from a real-time thread
+	 * @return Number of objects freed
+	 */
+	size_t scan() {
+		this->drain_readers();
+
+		void*  hazards[HAZARD_COUNT];
+		size_t hazard_count = 0;
+
+		for (const Slot& slot : this->slots) {
+			for (size_t hazard = 0; hazard < _hazards; hazard++) {
+				void* const ptr = slot.hazards[hazard].load(std::memory_order_seq_cst);
+
+				if (ptr != nullptr) {
+					hazards[hazard_count++] = ptr;
+				}
+			}
+		}
+
+		size_t count = 0;
+
+		std::erase_if(this->retired, [&](const Retired& retired) {
+			if (std::find(hazards, hazards + hazard_count, retired.ptr) != hazards + hazard_count) {
+				return false;
+			}
+
+			retired.deleter(retired.ptr);
+			count++;
+
+			return true;
+		});
+
+		return count;
+	}
+
+	/**
+	 * @brief Return the number of objects waiting for a scan, not counting the ones still queued by readers
+	 * @note Only call this from the reclaimer thread
+	 * @return Number of retired objects that have not been freed
+	 */
+	size_t retired_count() const noexcept {
+		return this->retired.size();
+	}
+
+	/**
+	 * @brief Return the max number of readers registered at once
+	 * @return Max number of readers registered at once
+	 */
+	constexpr size_t max_readers() const noexcept {
+		return _max_readers;
+	}
+
+private:
+	struct Retired {
+		void*   ptr     = nullptr;
+		Deleter deleter = nullptr;
+	};
+
+	// written by its reader on every protect, so every slot gets cache lines of its own
+	struct alignas(CACHE_LINE_SIZE) Slot {
+		typename _Traits::template atomic_type<void*> hazards[_hazards] = {}; // Objects protected by the reader, nullptr if unused
+		typename _Traits::template atomic_type<bool>  registered        = false;
+
+		SpscQueue<Retired, _retire_capacity, _Traits> retired; // Objects retired by the reader, consumed by scan
+	};
+
+	template<typename _T>
+	static void delete_object(void* const ptr) {
+		delete static_cast<_T*>(ptr);
+	}
+
+	/**
+	 * @brief Move the objects queued by readers to the retired list
+	 */
+	void drain_readers() {
+		Retired retired;
+
+		for (Slot& slot : this->slots) {
+			while (slot.retired.pop(&retired)) {
+				this->retired.push_back(retired);
+			}
+		}
+	}
+
+	Slot slots[_max_readers];
+
+	std::vector<Retired> retired;
+};
+} // namespace lfmq
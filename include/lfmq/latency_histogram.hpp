@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace lfmq
+{
+/*
+ * Fixed size log-linear histogram of durations. Every power of two range is
+ * split into SUB_BUCKETS linear buckets, so any recorded value lands in a
+ * bucket whose width is at most 1 / SUB_BUCKETS of its lower bound, across
+ * the whole uint64_t range, using a few kilobytes and never allocating.
+ *
+ * Only one thread may record into a histogram at a time, which lets record
+ * get away with relaxed loads and stores instead of read-modify-writes. Any
+ * thread may read, merge or export a histogram concurrently; the result is
+ * then a slightly stale but never torn view of every individual counter.
+ */
+class LatencyHistogram {
+public:
+	/// log2 of the number of linear buckets every power of two range is split into
+	static constexpr size_t SUB_BUCKET_BITS = 3;
+	static constexpr size_t SUB_BUCKETS     = size_t{ 1 } << SUB_BUCKET_BITS;
+	static constexpr size_t BUCKETS         = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+	LatencyHistogram() = default;
+	LatencyHistogram(const LatencyHistogram&) = delete;
+	LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+	/**
+	 * @brief Add a value to the histogram. Wait-free and allocation free
+	 * @note Only call this from one thread at a time
+	 * @param value Duration to be recorded, in whatever unit the clock ticks in
+	 */
+	void record(const uint64_t value) noexcept {
+		increment(this->counts[bucket_of(value)]);
+		increment(this->total);
+	}
+
+	/**
+	 * @brief Return the index of the bucket value falls into
+	 * @param value Value to be bucketed
+	 * @return Index of the bucket value falls into
+	 */
+	static constexpr size_t bucket_of(const uint64_t value) noexcept {
+		if (value < SUB_BUCKETS) {
+			return static_cast<size_t>(value);
+		}
+
+		const size_t shift = static_cast<size_t>(std::bit_width(value)) - 1 - SUB_BUCKET_BITS;
+
+		return (shift + 1) * SUB_BUCKETS + static_cast<size_t>((value >> shift) & (SUB_BUCKETS - 1));
+	}
+
+	/**
+	 * @brief Return the smallest value that falls into bucket
+	 * @param bucket Index of the bucket
+	 * @return Smallest value that falls into bucket
+	 */
+	static constexpr uint64_t bucket_lower_bound(const size_t bucket) noexcept {
+		if (bucket < SUB_BUCKETS) {
+			return bucket;
+		}
+
+		const size_t shift = bucket / SUB_BUCKETS - 1;
+
+		return static_cast<uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+	}
+
+	/**
+	 * @brief Return the number of values recorded into bucket
+	 * @param bucket Index of the bucket
+	 * @return Number of values recorded into bucket
+	 */
+	uint64_t bucket_count(const size_t bucket) const noexcept {
+		return this->counts[bucket].load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Return the number of values recorded
+	 * @return Number of values recorded
+	 */
+	uint64_t count() const noexcept {
+		return this->total.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Estimate the value below which the fraction quantile of the recorded values fall
+	 * @param quantile Fraction in [0, 1], for example 0.99 for the 99th percentile
+	 * @return Lower bound of the bucket containing the quantile, 0 if the histogram is empty
+	 */
+	uint64_t value_at_quantile(double quantile) const noexcept;
+
+	/**
+	 * @brief Add every count of other into this histogram
+	 * @note Only call this while no other thread is recording into this histogram
+	 * @param other Histogram to be merged in
+	 */
+	void merge(const LatencyHistogram& other) noexcept;
+
+	/**
+	 * @brief Reset every count to 0
+	 * @note Only call this while no other thread is recording into this histogram
+	 */
+	void reset() noexcept;
+
+	/**
+	 * @brief Call fn(lower_bound, count) for every non-empty bucket in increasing order
+	 * @param fn Callable invoked with the lower bound and count of each non-empty bucket
+	 */
+	template<typename _F>
+	void for_each_bucket(_F&& fn) const {
+		for (size_t i = 0; i < BUCKETS; i++) {
+			const uint64_t count = this->bucket_count(i);
+
+			if (count != 0) {
+				fn(bucket_lower_bound(i), count);
+			}
+		}
+	}
+
+private:
+	static void increment(std::atomic<uint64_t>& counter) noexcept {
+		counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+	std::atomic<uint64_t> counts[BUCKETS] = {};
+	std::atomic<uint64_t> total           = 0;
+};
+} // namespace lfmq
@@ -3,6 +3,9 @@
 #include <atomic>
 #include <tuple>
 
+#include "probes.hpp"
+#include "queue_policies.hpp"
+
 namespace lfmq
 {
 /*
@@ -13,10 +16,27 @@ namespace lfmq
  * the index which you will be writing to. If it is equal to the read index,
  * then the queue is full. Else, write to that index and increment the write
  * index member variable
+ *
+ * _Traits selects the compile-time policies of the queue, see
+ * queue_policies.hpp
+ *
+ * Each index is only ever stored by one side. The owner reads its own index
+ * relaxed, publishes it with a release store and reads the other side's
+ * index with an acquire load, so the consumer sees every element written
+ * before the write index moved past it and the producer never overwrites a
+ * slot before the consumer is done with it. The bench "model" scenario
+ * checks these orderings against the model checker in model_checker.hpp.
  */
-template <typename _T, size_t _size> requires std::is_default_constructible_v<_T> && (_size > 2)
+template <typename _T, size_t _size, typename _Traits = DefaultQueueTraits> requires std::is_default_constructible_v<_T> && (_size > 2)
 class SpscQueue {
 public:
+	using value_type           = _T;
+	using latency_tracker_type = typename _Traits::latency_policy::template Tracker<_size>;
+	using stats_recorder_type  = typename _Traits::stats_policy::template Recorder<_size>;
+	using trace_recorder_type  = typename _Traits::trace_policy::template Recorder<_T>;
+	using storage_type         = typename _Traits::storage_policy::template Storage<_T, _size>;
+	using index_type           = typename _Traits::template atomic_type<size_t>;
+
 	/**
 	 * @brief Insert an element onto the queue
 	 * @note Only call this from the producer thread
@@ -36,6 +56,45 @@ public:
 		return this->_push(std::move(element));
 	}
 
+	/**
+	 * @brief Insert an element onto the queue by filling its slot in place instead of copying a finished element in
+	 * @note Only call this from the producer thread. The slot holds whatever element last used it, so fill must set every field the consumer reads
+	 * @param fill Called as fill(slot) with a reference to the slot at the write index
+	 * @return Whether the element was successfully inserted onto the queue
+	 */
+	template<typename _Fill>
+	bool push_with(_Fill&& fill) {
+		const size_t curr_write_index = this->write_index.load(std::memory_order_relaxed);
+		size_t       next_index       = curr_write_index + 1;
+
+		if (next_index == this->capacity()) {
+			next_index = 0;
+		}
+
+		// the slot at the write index is the one the ring always keeps free, so the consumer is done with it even when the queue is full
+		_T& slot = this->elements[curr_write_index];
+		std::forward<_Fill>(fill)(slot);
+
+		const size_t curr_read_index = this->read_index.load(std::memory_order_acquire);
+
+		// queue is full
+		if (curr_read_index == next_index) {
+			LFMQ_PROBE4(push_failed, this, curr_write_index, curr_read_index, element_message_type(slot));
+			this->stats_recorder.on_push_failed();
+			this->trace_recorder.on_push_failed(slot);
+			return false;
+		}
+
+		this->latency_tracker.on_push(curr_write_index);
+		this->stats_recorder.on_push((next_index + _size - curr_read_index) % _size);
+		this->trace_recorder.on_push(slot);
+		LFMQ_PROBE4(push, this, curr_write_index, next_index, element_message_type(slot));
+
+		this->write_index.store(next_index, std::memory_order_release);
+
+		return true;
+	}
+
 	/**
 	 * @brief Remove the oldest element from the queue
 	 * @note Only call this from the consumer thread
@@ -43,24 +102,30 @@ public:
 	 * @return True if the queue has elements and value was popped, false if the queue is empty
 	 */
 	bool pop(_T* const element = nullptr) {
-		size_t curr_read_index = this->read_index.load();
-		const size_t curr_write_index = this->write_index.load();
+		size_t curr_read_index = this->read_index.load(std::memory_order_relaxed);
+		const size_t curr_write_index = this->write_index.load(std::memory_order_acquire);
 
 		// queue is empty
 		if (curr_read_index == curr_write_index) {
 			return false;
 		}
 
+		LFMQ_PROBE4(pop, this, curr_read_index, curr_write_index, element_message_type(this->elements[curr_read_index]));
+		this->trace_recorder.on_pop(this->elements[curr_read_index]);
+
 		if (element != nullptr) {
 			*element = this->elements[curr_read_index];
 		}
 
+		this->latency_tracker.on_pop(curr_read_index);
+		this->stats_recorder.on_pop();
+
 		curr_read_index++;
 		if (curr_read_index == this->capacity()) {
 			curr_read_index = 0;
 		}
 
-		this->read_index.store(curr_read_index);
+		this->read_index.store(curr_read_index, std::memory_order_release);
 
 		return true;
 	}
@@ -71,7 +136,7 @@ public:
 	 * @return Const reference to the element at the start of the queue
 	 */
 	const _T& front() const noexcept {
-		return this->elements[this->read_index.load()];
+		return this->elements[this->read_index.load(std::memory_order_relaxed)];
 	}
 
 	/**
@@ -80,7 +145,7 @@ public:
 	 * @return Reference to the element at the start of the queue
 	 */
 	_T& front() noexcept {
-		return this->elements[this->read_index.load()];
+		return this->elements[this->read_index.load(std::memory_order_relaxed)];
 	}
 
 	/**
@@ -96,9 +161,139 @@ public:
 	 * @return Whether the queue is empty
 	 */
 	bool is_empty() const noexcept {
-		return this->read_index.load() == this->write_index.load();
+		return this->read_index.load(std::memory_order_acquire) == this->write_index.load(std::memory_order_acquire);
+	}
+
+	/**
+	 * @brief Return the latency tracker selected by the latency policy
+	 * @return Latency tracker of the queue
+	 */
+	const latency_tracker_type& latency() const noexcept {
+		return this->latency_tracker;
+	}
+
+	/**
+	 * @brief Return the latency tracker selected by the latency policy
+	 * @return Latency tracker of the queue
+	 */
+	latency_tracker_type& latency() noexcept {
+		return this->latency_tracker;
+	}
+
+	/**
+	 * @brief Return the counters kept by the stats policy
+	 * @note May be called from any thread. Every counter is 0 unless the stats policy is QueueStats
+	 * @return Snapshot of the counters along with the current occupancy
+	 */
+	QueueStatsSnapshot stats() const noexcept {
+		QueueStatsSnapshot snapshot = this->stats_recorder.snapshot();
+
+		const size_t curr_read_index  = this->read_index.load(std::memory_order_relaxed);
+		const size_t curr_write_index = this->write_index.load(std::memory_order_relaxed);
+		snapshot.occupancy = (curr_write_index + _size - curr_read_index) % _size;
+
+		return snapshot;
+	}
+
+	/**
+	 * @brief Return the recorder selected by the trace policy, for example to set the queue id of MessageTracing
+	 * @return Trace recorder of the queue
+	 */
+	trace_recorder_type& trace() noexcept {
+		return this->trace_recorder;
 	}
 
+	/**
+	 * @brief Return the ring storage selected by the storage policy, for example to check whether MappedStorage got huge pages
+	 * @return Ring storage of the queue
+	 */
+	const storage_type& storage() const noexcept {
+		return this->elements;
+	}
+
+	class Frame;
+
+	/**
+	 * @brief Start a frame of elements that become visible to the consumer all at once
+	 * @note Only call this from the producer thread, and do not call push while the frame is open
+	 * @return Frame to push the elements onto
+	 */
+	Frame begin_frame() noexcept {
+		return Frame(*this);
+	}
+
+	/*
+	 * A frame stages elements in the free part of the ring without moving the
+	 * write index, so the consumer cannot see any of them. commit publishes the
+	 * whole frame with a single store of the write index. A frame that is
+	 * destroyed without being committed is discarded.
+	 */
+	class Frame {
+	public:
+		Frame(const Frame&) = delete;
+		Frame& operator=(const Frame&) = delete;
+
+		~Frame() = default;
+
+		/**
+		 * @brief Stage an element in the frame
+		 * @param element Element to be staged
+		 * @return Whether the element was staged, false if the queue does not have room for it
+		 */
+		bool push(const _T& element) {
+			return this->queue._write(this->write_index, element);
+		}
+		/**
+		 * @brief Stage an element in the frame
+		 * @param element Element to be staged
+		 * @return Whether the element was staged, false if the queue does not have room for it
+		 */
+		bool push(_T&& element) noexcept {
+			return this->queue._write(this->write_index, std::move(element));
+		}
+
+		/**
+		 * @brief Make every staged element visible to the consumer
+		 * @note The frame can keep being used afterwards to stage the next set of elements
+		 */
+		void commit() noexcept {
+			this->queue.write_index.store(this->write_index, std::memory_order_release);
+			this->committed_index = this->write_index;
+		}
+
+		/**
+		 * @brief Discard every element staged since the frame began or was last committed
+		 */
+		void abort() noexcept {
+			this->write_index = this->committed_index;
+		}
+
+		/**
+		 * @brief Return the number of staged elements that have not been committed
+		 * @return Number of staged elements that have not been committed
+		 */
+		size_t size() const noexcept {
+			if (this->write_index >= this->committed_index) {
+				return this->write_index - this->committed_index;
+			}
+
+			return this->queue.capacity() - this->committed_index + this->write_index;
+		}
+
+	private:
+		friend class SpscQueue;
+
+		explicit Frame(SpscQueue& queue) noexcept :
+				queue(queue),
+				committed_index(queue.write_index.load(std::memory_order_relaxed)),
+				write_index(committed_index)
+		{ }
+
+		SpscQueue& queue;
+		size_t     committed_index;
+		size_t     write_index;
+	};
+
 private:
 	/**
 	 * @brief Insert an element onto the queue
@@ -108,33 +303,64 @@ private:
 	 */
 	template<typename _fr_T>
 	bool _push(_fr_T&& element) {
-		// TODO read more of this page to optimize memory order https://en.cppreference.com/w/cpp/atomic/memory_order
-		const size_t curr_write_index = this->write_index.load();
-		size_t next_write_index = curr_write_index + 1;
+		size_t curr_write_index = this->write_index.load(std::memory_order_relaxed);
 
-		if (next_write_index == this->capacity()) {
-			next_write_index = 0;
+		if (!this->_write(curr_write_index, std::forward<_fr_T>(element))) {
+			return false;
 		}
 
+		this->write_index.store(curr_write_index, std::memory_order_release);
+
+		return true;
+	}
+
+	/**
+	 * @brief Write an element at index without publishing it to the consumer
+	 * @note Only call this from the producer thread
+	 * @param index Index to write to. Advanced to the next index if the write succeeds
+	 * @param element Forwarding reference element to be written
+	 * @return Whether the element was written, false if the queue is full
+	 */
+	template<typename _fr_T>
+	bool _write(size_t& index, _fr_T&& element) {
+		size_t next_index = index + 1;
+
+		if (next_index == this->capacity()) {
+			next_index = 0;
+		}
+
+		const size_t curr_read_index = this->read_index.load(std::memory_order_acquire);
+
 		// queue is full
-		if (this->read_index.load() == next_write_index) {
+		if (curr_read_index == next_index) {
+			LFMQ_PROBE4(push_failed, this, index, curr_read_index, element_message_type(element));
+			this->stats_recorder.on_push_failed();
+			this->trace_recorder.on_push_failed(element);
 			return false;
 		}
 
-		this->elements[curr_write_index] = std::forward<_fr_T>(element);
-		this->write_index.store(next_write_index);
+		this->elements[index] = std::forward<_fr_T>(element);
+		this->latency_tracker.on_push(index);
+		this->stats_recorder.on_push((next_index + _size - curr_read_index) % _size);
+		this->trace_recorder.on_push(this->elements[index]);
+		LFMQ_PROBE4(push, this, index, next_index, element_message_type(this->elements[index]));
+		index = next_index;
 
 		return true;
 	}
 
-	_T elements[_size];
+	storage_type elements;
+
+	index_type read_index  = 0;
+	index_type write_index = 0;
 
-	std::atomic<size_t> read_index  = 0;
-	std::atomic<size_t> write_index = 0;
+	[[no_unique_address]] latency_tracker_type latency_tracker;
+	[[no_unique_address]] stats_recorder_type  stats_recorder;
+	[[no_unique_address]] trace_recorder_type  trace_recorder;
 };
 } // namespace lfmq
 
 /// Tuple size specialization for SpscQueue
-template<typename _T, size_t _size>
-struct std::tuple_size<lfmq::SpscQueue<_T, _size>> : public std::integral_constant<std::size_t, _size>
+template<typename _T, size_t _size, typename _Traits>
+struct std::tuple_size<lfmq::SpscQueue<_T, _size, _Traits>> : public std::integral_constant<std::size_t, _size>
 {};
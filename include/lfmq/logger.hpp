@@ -0,0 +1,194 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace lfmq
+{
+/*
+ * Real-time safe logging. A thread logs by pushing a compact binary record
+ * into its own lock-free ring buffer: the address of the format string, a
+ * formatter instantiated for the argument types at the call site, and the
+ * raw bits of up to LOG_MAX_ARGS arguments. A LogWriter thread drains every
+ * ring, formats the records with snprintf and writes them to a file in
+ * batches, so the logging thread never formats, allocates or makes a system
+ * call.
+ *
+ * The format string is never copied, so it must have static storage
+ * duration, as string literals do. The same goes for every const char*
+ * argument: only the pointer is recorded. Records are only recorded while a
+ * LogWriter is running and the level is at or above the writer's, so a
+ * disabled log_event costs a single relaxed load.
+ */
+
+enum class LogLevel : uint8_t {
+	VERBOSE,
+	INFO,
+	WARNING,
+	ERROR
+};
+
+/// Number of records each thread can buffer before the writer drains them
+inline constexpr size_t LOG_BUFFER_SIZE = 4096;
+
+/// Max number of arguments of a single log_event
+inline constexpr size_t LOG_MAX_ARGS = 6;
+
+namespace detail
+{
+/// Formats the arguments of a record into buffer, as snprintf would
+using LogFormatter = int (*)(char* buffer, size_t size, const char* format, const uint64_t* args);
+
+struct LogRecord {
+	uint64_t     timestamp          = 0; // TscClock ticks, converted to nanoseconds by the writer
+	const char*  format             = nullptr;
+	LogFormatter formatter          = nullptr;
+	uint64_t     args[LOG_MAX_ARGS] = {};
+	LogLevel     level              = LogLevel::INFO;
+};
+
+/// Lowest level that is recorded, LOG_OFF while no LogWriter is running
+extern std::atomic<uint8_t> log_threshold;
+
+inline constexpr uint8_t LOG_OFF = UINT8_MAX;
+
+/// Fills a record directly in the log buffer of the calling thread. Only the first count args are copied, the formatter never reads the others
+void record_log_event(LogLevel level, const char* format, LogFormatter formatter, const uint64_t* args, size_t count) noexcept;
+
+/// snprintf through a va_list, so that a record without arguments still goes through its format
+int format_log_line(char* buffer, size_t size, const char* format, ...);
+
+template<typename _A>
+concept LogArgument = (std::is_arithmetic_v<_A> || std::is_enum_v<_A> || std::is_pointer_v<_A>) && sizeof(_A) <= sizeof(uint64_t);
+
+template<LogArgument _A>
+uint64_t to_log_argument(const _A value) noexcept {
+	uint64_t bits = 0;
+	std::memcpy(&bits, &value, sizeof(_A));
+	return bits;
+}
+
+template<LogArgument _A>
+auto from_log_argument(const uint64_t bits) noexcept {
+	_A value;
+	std::memcpy(&value, &bits, sizeof(_A));
+
+	if constexpr (std::is_enum_v<_A>) {
+		return static_cast<std::underlying_type_t<_A>>(value);
+	} else {
+		return value;
+	}
+}
+
+template<typename... _Args, size_t... _indices>
+int format_log_arguments(char* const buffer, const size_t size, const char* const format, const uint64_t* const args, std::index_sequence<_indices...>) {
+	return format_log_line(buffer, size, format, from_log_argument<_Args>(args[_indices])...);
+}
+
+template<typename... _Args>
+int format_log_record(char* const buffer, const size_t size, const char* const format, const uint64_t* const args) {
+	return format_log_arguments<_Args...>(buffer, size, format, args, std::index_sequence_for<_Args...>());
+}
+} // namespace detail
+
+/**
+ * @brief Return whether records of the given level are currently recorded
+ * @param level Level of the record
+ * @return Whether a LogWriter is running and level is at or above its level
+ */
+inline bool is_logging(const LogLevel level) noexcept {
+	return static_cast<uint8_t>(level) >= detail::log_threshold.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Allocate the log buffer of the calling thread and give the thread a name in the log
+ * @note Real-time threads must call this before entering their real-time loop, since the first record of an unregistered thread allocates its buffer
+ * @param name Name of the thread written with each of its records. Copied
+ */
+void register_log_thread(const char* name);
+
+/**
+ * @brief Record a printf style log line into the log buffer of the calling thread. Dropped if the buffer is full. Wait-free
+ * @param level Level of the record
+ * @param format printf format string with static storage duration, such as a string literal
+ * @param args Arithmetic, enum or pointer arguments matching format. Strings are recorded by pointer and must outlive the writer
+ */
+template<typename... _Args> requires (sizeof...(_Args) <= LOG_MAX_ARGS) && (detail::LogArgument<_Args> && ...)
+inline void log_event(const LogLevel level, const char* const format, const _Args... args) noexcept {
+	if (!is_logging(level)) {
+		return;
+	}
+
+	const std::array<uint64_t, sizeof...(_Args)> arguments = { detail::to_log_argument(args)... };
+
+	detail::record_log_event(level, format, &detail::format_log_record<_Args...>, arguments.data(), arguments.size());
+}
+
+/*
+ * Background thread that drains the log buffers of every registered thread,
+ * formats the records and writes them to a file, one line per record. Only
+ * one writer can run at a time.
+ *
+ * The lines of each drain are sorted by timestamp across threads. Drains do
+ * not overlap in time though: a record a thread logs while another thread's
+ * buffer is being drained can land in the next batch, after lines that are a
+ * little newer.
+ */
+class LogWriter {
+public:
+	LogWriter();
+	LogWriter(const LogWriter&) = delete;
+	LogWriter& operator=(const LogWriter&) = delete;
+
+	/**
+	 * @brief Stop the writer if it is still running
+	 */
+	~LogWriter();
+
+	/**
+	 * @brief Open path and start collecting records
+	 * @param path File to append the log to
+	 * @param level Lowest level that is recorded
+	 * @param flush_interval How often the log buffers are drained
+	 * @return True if the writer started, false if the file could not be opened or another writer is running
+	 */
+	bool start(const char* path, LogLevel level = LogLevel::INFO, std::chrono::milliseconds flush_interval = std::chrono::milliseconds(20));
+
+	/**
+	 * @brief Stop collecting records, write what is left and close the file
+	 */
+	void stop();
+
+	/**
+	 * @brief Change the lowest level that is recorded while the writer runs
+	 * @param level Lowest level that is recorded
+	 */
+	void set_level(LogLevel level) noexcept;
+
+	/**
+	 * @brief Return the number of records written so far, or by the last run once stopped
+	 * @return Number of records written
+	 */
+	uint64_t records_written() const noexcept;
+
+private:
+	struct State;
+
+	std::unique_ptr<State> state;
+	uint64_t               last_written = 0;
+};
+
+/**
+ * @brief Return the name of a log level as written to the log
+ * @param level Log level
+ * @return Name of the level
+ */
+const char* log_level_name(LogLevel level) noexcept;
+} // namespace lfmq
@@ -4,6 +4,9 @@
 #include <cstdint>
 #include <memory>
 #include <stdexcept>
+#include <type_traits>
+
+#include "probes.hpp"
 
 namespace lfmq
 {
@@ -21,17 +24,45 @@ enum class MessageType {
 	PLAY_AT          // begin playing at specific time or frame index
 };
 
+/// Number of enumerators of MessageType, for tables indexed by message type
+inline constexpr size_t MESSAGE_TYPE_COUNT = static_cast<size_t>(MessageType::PLAY_AT) + 1;
+
+/**
+ * @brief Return the name of a message type
+ * @param type Message type
+ * @return Name of the enumerator, "UNKNOWN" for values outside of the enumeration
+ */
+const char* message_type_name(const MessageType type) noexcept;
+
 class MessageMetadata {
+public:
+	/// Frame time of a message that should be applied as soon as it is received
+	static constexpr uint64_t NO_FRAME_TIME = UINT64_MAX;
+	/// Correlation id of a message that does not expect a response
+	static constexpr uint32_t NO_CORRELATION_ID = 0;
+
 private:
 	MessageType m_type;
+	uint64_t    m_frame_time;
+	uint32_t    m_correlation_id;
 
 public:
 	constexpr MessageMetadata() noexcept :
-			m_type(MessageType::UNKNOWN)
+			m_type(MessageType::UNKNOWN),
+			m_frame_time(NO_FRAME_TIME),
+			m_correlation_id(NO_CORRELATION_ID)
 	{ }
 
 	constexpr MessageMetadata(const MessageType type) noexcept :
-			m_type(type)
+			m_type(type),
+			m_frame_time(NO_FRAME_TIME),
+			m_correlation_id(NO_CORRELATION_ID)
+	{ }
+
+	constexpr MessageMetadata(const MessageType type, const uint64_t frame_time) noexcept :
+			m_type(type),
+			m_frame_time(frame_time),
+			m_correlation_id(NO_CORRELATION_ID)
 	{ }
 
 	constexpr MessageType get_type() const noexcept {
@@ -39,6 +70,47 @@ public:
 	}
 
 	void set_type(const MessageType type) noexcept;
+
+	/**
+	 * @brief Return whether the message is stamped with the frame it should be applied at
+	 * @return Whether the message is stamped with the frame it should be applied at
+	 */
+	constexpr bool has_frame_time() const noexcept {
+		return this->m_frame_time != NO_FRAME_TIME;
+	}
+
+	/**
+	 * @brief Return the absolute frame index the message should be applied at
+	 * @return Absolute frame index the message should be applied at, NO_FRAME_TIME if it is not stamped
+	 */
+	constexpr uint64_t get_frame_time() const noexcept {
+		return this->m_frame_time;
+	}
+
+	/**
+	 * @brief Stamp the message with the absolute frame index it should be applied at
+	 * @param frame_time Absolute frame index in the audio stream. NO_FRAME_TIME clears the stamp
+	 */
+	void set_frame_time(const uint64_t frame_time) noexcept;
+
+	/**
+	 * @brief Remove the frame time stamp so that the message is applied as soon as it is received
+	 */
+	void clear_frame_time() noexcept;
+
+	/**
+	 * @brief Return the id that ties the message to the response expected for it
+	 * @return Correlation id of the message, NO_CORRELATION_ID if no response is expected
+	 */
+	constexpr uint32_t get_correlation_id() const noexcept {
+		return this->m_correlation_id;
+	}
+
+	/**
+	 * @brief Set the id that ties the message to the response expected for it
+	 * @param correlation_id Correlation id, usually taken from a CompletionTable ticket
+	 */
+	void set_correlation_id(const uint32_t correlation_id) noexcept;
 };
 
 class Message {
@@ -131,9 +203,18 @@ public:
 	friend void swap(Message& lhs, Message& rhs) noexcept {
 		using std::swap;
 
-		swap(lhs.metadata, lhs.metadata);
+		swap(lhs.metadata, rhs.metadata);
 		swap(lhs.payload, rhs.payload);
 		swap(lhs.payload_size, rhs.payload_size);
 	}
 };
+
+/**
+ * @brief Return the message type of a queue element that is a Message, for tracing and probes
+ * @param element Message
+ * @return MessageType of element as an integer
+ */
+constexpr int16_t element_message_type(const Message& element) noexcept {
+	return static_cast<int16_t>(element.get_metadata().get_type());
+}
 } // namespace lfmq
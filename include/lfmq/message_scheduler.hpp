@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstdint>
+
+#include "lock_free_queue.hpp"
+#include "message.hpp"
+
+namespace lfmq
+{
+/*
+ * The message scheduler lives on the consumer (audio) thread and turns the
+ * block-quantized stream of messages coming out of an SpscQueue into a
+ * sample-accurate one. Messages are held in a fixed size binary min-heap
+ * ordered by frame time, so nothing is ever allocated. Every block, the
+ * messages that fall inside [block_start, block_start + block_frames) are
+ * dispatched in frame order along with their offset into the block, and the
+ * future-dated ones stay in the heap for a later block. Messages without a
+ * frame time, or whose frame time has already passed, are dispatched at
+ * offset 0 of the next block. Messages with equal frame times are
+ * dispatched in the order they were scheduled.
+ */
+template <size_t _capacity> requires (_capacity > 0)
+class MessageScheduler {
+public:
+	MessageScheduler() noexcept {
+		for (size_t i = 0; i < _capacity; i++) {
+			this->free_slots[i] = _capacity - 1 - i;
+		}
+	}
+
+	/**
+	 * @brief Hold a message until the block containing its frame time is dispatched
+	 * @param message Message to be scheduled
+	 * @return Whether the message was scheduled, false if the scheduler is full
+	 */
+	bool schedule(const Message& message) {
+		if (this->is_full()) {
+			return false;
+		}
+
+		const size_t slot = this->free_slots[--this->free_count];
+		this->messages[slot] = message;
+		this->insert(slot);
+
+		return true;
+	}
+
+	/**
+	 * @brief Move messages from queue into the scheduler until either the queue is empty or the scheduler is full
+	 * @note Only call this from the consumer thread of queue
+	 * @param queue Queue to pop messages from
+	 * @return Number of messages that were moved into the scheduler
+	 */
+	template<size_t _size, typename _Traits>
+	size_t drain(SpscQueue<Message, _size, _Traits>& queue) {
+		size_t count = 0;
+
+		while (!this->is_full()) {
+			const size_t slot = this->free_slots[this->free_count - 1];
+
+			if (!queue.pop(&this->messages[slot])) {
+				break;
+			}
+
+			this->free_count--;
+			this->insert(slot);
+			count++;
+		}
+
+		return count;
+	}
+
+	/**
+	 * @brief Dispatch every message whose frame time falls before the end of the block, in frame order
+	 * @param block_start Absolute frame index of the first frame in the block
+	 * @param block_frames Number of frames in the block
+	 * @param fn Callable invoked as fn(const Message&, size_t sample_offset) for each due message
+	 * @return Number of messages that were dispatched
+	 */
+	template<typename _F>
+	size_t dispatch_block(const uint64_t block_start, const size_t block_frames, _F&& fn) {
+		const uint64_t block_end = block_start + block_frames;
+		size_t         count     = 0;
+
+		while (this->size() > 0 && this->heap[0].frame_time < block_end) {
+			const Entry entry = this->remove_top();
+
+			const size_t offset = entry.frame_time > block_start ? static_cast<size_t>(entry.frame_time - block_start) : 0;
+			fn(static_cast<const Message&>(this->messages[entry.slot]), offset);
+
+			this->free_slots[this->free_count++] = entry.slot;
+			count++;
+		}
+
+		return count;
+	}
+
+	/**
+	 * @brief Return the frame time of the next message to be dispatched
+	 * @return Frame time of the next message, 0 if it should be dispatched immediately, NO_FRAME_TIME if the scheduler is empty
+	 */
+	uint64_t next_frame_time() const noexcept {
+		return this->size() > 0 ? this->heap[0].frame_time : MessageMetadata::NO_FRAME_TIME;
+	}
+
+	/**
+	 * @brief Return the number of messages being held
+	 * @return Number of messages being held
+	 */
+	size_t size() const noexcept {
+		return this->heap_size;
+	}
+
+	/**
+	 * @brief Return the max number of messages that can be held
+	 * @return Max number of messages that can be held
+	 */
+	constexpr size_t capacity() const noexcept {
+		return _capacity;
+	}
+
+	/**
+	 * @brief Return whether the scheduler is holding any messages
+	 * @return Whether the scheduler is holding any messages
+	 */
+	bool is_empty() const noexcept {
+		return this->size() == 0;
+	}
+
+	/**
+	 * @brief Return whether the scheduler can hold another message
+	 * @return Whether the scheduler is full
+	 */
+	bool is_full() const noexcept {
+		return this->free_count == 0;
+	}
+
+private:
+	struct Entry {
+		uint64_t frame_time = 0;
+		uint64_t sequence   = 0;
+		size_t   slot       = 0;
+
+		bool operator<(const Entry& other) const noexcept {
+			if (this->frame_time != other.frame_time) {
+				return this->frame_time < other.frame_time;
+			}
+
+			return this->sequence < other.sequence;
+		}
+	};
+
+	/**
+	 * @brief Push the message in slot onto the heap
+	 * @param slot Index into messages of the message to be pushed
+	 */
+	void insert(const size_t slot) noexcept {
+		const MessageMetadata& metadata = this->messages[slot].get_metadata();
+
+		Entry entry;
+		// unstamped messages are due immediately
+		entry.frame_time = metadata.has_frame_time() ? metadata.get_frame_time() : 0;
+		entry.sequence   = this->next_sequence++;
+		entry.slot       = slot;
+
+		// sift up
+		size_t index = this->heap_size++;
+		while (index > 0) {
+			const size_t parent = (index - 1) / 2;
+
+			if (!(entry < this->heap[parent])) {
+				break;
+			}
+
+			this->heap[index] = this->heap[parent];
+			index = parent;
+		}
+
+		this->heap[index] = entry;
+	}
+
+	/**
+	 * @brief Pop the earliest entry off of the heap
+	 * @note The slot of the returned entry is not returned to the free list
+	 * @return Earliest entry
+	 */
+	Entry remove_top() noexcept {
+		const Entry  top  = this->heap[0];
+		const size_t last = --this->heap_size;
+		const Entry  tail = this->heap[last];
+
+		// sift down
+		size_t index = 0;
+		while (true) {
+			size_t child = 2 * index + 1;
+
+			if (child >= last) {
+				break;
+			}
+
+			if (child + 1 < last && this->heap[child + 1] < this->heap[child]) {
+				child++;
+			}
+
+			if (!(this->heap[child] < tail)) {
+				break;
+			}
+
+			this->heap[index] = this->heap[child];
+			index = child;
+		}
+
+		this->heap[index] = tail;
+
+		return top;
+	}
+
+	Message  messages[_capacity];
+	Entry    heap[_capacity];
+	size_t   free_slots[_capacity];
+	size_t   free_count    = _capacity;
+	size_t   heap_size     = 0;
+	uint64_t next_sequence = 0;
+};
+} // namespace lfmq
@@ -0,0 +1,366 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "queue_policies.hpp"
+
+namespace lfmq::model
+{
+/*
+ * Stateless model checker for the lock-free structures of lfmq, in the
+ * spirit of Relacy and CDSChecker. A test runs a handful of threads against
+ * a structure whose atomics are model::Atomic instead of std::atomic, which
+ * SpscQueue picks up through the atomic_type of its traits:
+ *
+ *   struct QueueTest {
+ *       static constexpr size_t THREADS = 2;
+ *
+ *       lfmq::SpscQueue<lfmq::model::Var<int>, 3, lfmq::model::ModelQueueTraits> queue;
+ *
+ *       void thread(size_t index);   // body of thread index, must terminate
+ *       void finish();               // runs after every thread has finished
+ *   };
+ *   lfmq::model::CheckReport report = lfmq::model::check_model<QueueTest>();
+ *
+ * The threads are serialized and every atomic operation is a scheduling
+ * point, so check_model can enumerate, depth first, every interleaving the
+ * test allows within a preemption bound. Every load also chooses which store
+ * it reads from among the ones the C++ memory model allows it to see, so a
+ * relaxed or acquire load can return a stale value just like it can on a
+ * weakly ordered CPU:
+ *
+ * - A load never reads a store older than one its thread already observed
+ *   or one that happens before the load (coherence)
+ * - An acquire load that reads a release store, or a release sequence of
+ *   read-modify-writes headed by one, synchronizes with the storing thread
+ * - seq_cst operations always read the latest store, which is exact as long
+ *   as every access to a location is seq_cst
+ * - Read-modify-writes, including failed compare_exchanges, always read the
+ *   latest store
+ *
+ * Plain data shared between threads is wrapped in model::Var, which checks
+ * every access with vector clocks and reports unsynchronized accesses as data
+ * races, regardless of whether the interleaving made them visible. Fences,
+ * consume ordering and spurious compare_exchange_weak failures are not
+ * modelled. Thread bodies must finish in a bounded number of steps, so spin
+ * loops have to be written as a bounded number of attempts.
+ */
+
+/// Largest number of threads a test can run
+inline constexpr size_t MAX_THREADS = 4;
+
+/*
+ * Limits of the exploration
+ */
+struct CheckOptions {
+	size_t   preemption_bound = 3;         // Most times a runnable thread may be switched away from per execution
+	uint64_t max_executions   = 1'000'000; // Executions explored before giving up
+};
+
+/*
+ * Outcome of check_model
+ */
+struct CheckReport {
+	uint64_t    executions = 0;     // Executions explored
+	bool        exhausted  = false; // Whether every execution within the preemption bound was explored
+	std::string failure;            // First failure found, empty if none
+
+	/**
+	 * @brief Return whether no execution failed
+	 * @return Whether no execution failed
+	 */
+	bool passed() const noexcept {
+		return this->failure.empty();
+	}
+};
+
+/**
+ * @brief Fail the current execution if condition does not hold
+ * @note Does nothing outside of check_model
+ * @param condition Condition that has to hold in every execution
+ * @param message Description of the failure, copied
+ */
+void check(bool condition, const char* message);
+
+namespace detail
+{
+/// Vector clock indexed by thread, where slot MAX_THREADS is the thread running the setup and finish of a test
+using VectorClock = std::array<uint32_t, MAX_THREADS + 1>;
+
+/*
+ * Modification order and visibility of a single model::Atomic, holding every
+ * value stored to it during the current execution as a 64 bit pattern
+ */
+class AtomicLocation {
+public:
+	explicit AtomicLocation(uint64_t initial);
+	AtomicLocation(const AtomicLocation&) = delete;
+	AtomicLocation& operator=(const AtomicLocation&) = delete;
+
+	uint64_t load(std::memory_order order);
+	void store(uint64_t value, std::memory_order order);
+
+	/**
+	 * @brief Atomically replace the latest value with op(latest value, operand)
+	 * @return Value before the operation
+	 */
+	uint64_t read_modify_write(std::memory_order order, uint64_t (*op)(uint64_t, uint64_t), uint64_t operand);
+
+	bool compare_exchange(uint64_t& expected, uint64_t desired, std::memory_order success, std::memory_order failure);
+
+private:
+	struct Store {
+		uint64_t    value  = 0;
+		size_t      thread = 0;
+		uint32_t    epoch  = 0;  // Clock of the storing thread when it stored
+		VectorClock release{};   // What an acquire load reading this store synchronizes with
+	};
+
+	void append(uint64_t value, std::memory_order order, const VectorClock* inherited);
+
+	std::vector<Store>                  history;
+	std::array<size_t, MAX_THREADS + 1> observed{}; // Latest store each thread has seen
+};
+
+/*
+ * Race detector of a single model::Var. Remembers the last write and the last
+ * read of every thread, and reports any access that does not happen after
+ * a conflicting one.
+ */
+class DataLocation {
+public:
+	DataLocation();
+	DataLocation(const DataLocation&) = delete;
+	DataLocation& operator=(const DataLocation&) = delete;
+
+	void on_read();
+	void on_write();
+
+private:
+	size_t                                writer      = MAX_THREADS;
+	uint32_t                              write_epoch = 0;
+	std::array<uint32_t, MAX_THREADS + 1> read_epochs{};
+};
+
+/**
+ * @brief Run every execution of a test within the bounds of options
+ * @param threads Number of threads of the test
+ * @param begin Called before every execution to construct the test
+ * @param run Called on every thread with its index
+ * @param end Called after every thread of an execution has finished
+ */
+CheckReport explore(const CheckOptions& options, size_t threads, const std::function<void()>& begin, const std::function<void(size_t)>& run, const std::function<void()>& end);
+
+template <typename _V>
+uint64_t to_bits(const _V value) noexcept {
+	uint64_t bits = 0;
+	std::memcpy(&bits, &value, sizeof(_V));
+	return bits;
+}
+
+template <typename _V>
+_V from_bits(const uint64_t bits) noexcept {
+	_V value;
+	std::memcpy(&value, &bits, sizeof(_V));
+	return value;
+}
+} // namespace detail
+
+/*
+ * Drop-in replacement for std::atomic whose operations are scheduling points
+ * of the model checker and follow the simulated memory model. Outside of
+ * check_model it behaves like a plain single-threaded variable.
+ */
+template <typename _V> requires std::is_trivially_copyable_v<_V> && (sizeof(_V) <= sizeof(uint64_t))
+class Atomic {
+public:
+	static constexpr bool is_always_lock_free = true;
+
+	Atomic() :
+			Atomic(_V())
+	{ }
+
+	Atomic(const _V value) :
+			location(detail::to_bits(value))
+	{ }
+
+	Atomic(const Atomic&) = delete;
+	Atomic& operator=(const Atomic&) = delete;
+
+	_V load(const std::memory_order order = std::memory_order_seq_cst) const {
+		return detail::from_bits<_V>(this->location.load(order));
+	}
+
+	void store(const _V value, const std::memory_order order = std::memory_order_seq_cst) {
+		this->location.store(detail::to_bits(value), order);
+	}
+
+	_V exchange(const _V value, const std::memory_order order = std::memory_order_seq_cst) {
+		return detail::from_bits<_V>(this->location.read_modify_write(order, [](uint64_t, const uint64_t operand) { return operand; }, detail::to_bits(value)));
+	}
+
+	bool compare_exchange_strong(_V& expected, const _V desired, const std::memory_order success, const std::memory_order failure) {
+		uint64_t bits = detail::to_bits(expected);
+		const bool exchanged = this->location.compare_exchange(bits, detail::to_bits(desired), success, failure);
+		expected = detail::from_bits<_V>(bits);
+		return exchanged;
+	}
+
+	bool compare_exchange_strong(_V& expected, const _V desired, const std::memory_order order = std::memory_order_seq_cst) {
+		return this->compare_exchange_strong(expected, desired, order, failure_order(order));
+	}
+
+	bool compare_exchange_weak(_V& expected, const _V desired, const std::memory_order success, const std::memory_order failure) {
+		return this->compare_exchange_strong(expected, desired, success, failure);
+	}
+
+	bool compare_exchange_weak(_V& expected, const _V desired, const std::memory_order order = std::memory_order_seq_cst) {
+		return this->compare_exchange_strong(expected, desired, order, failure_order(order));
+	}
+
+	_V fetch_add(const _V operand, const std::memory_order order = std::memory_order_seq_cst) requires std::is_integral_v<_V> {
+		return this->apply(order, operand, [](const uint64_t value, const uint64_t operand) { return detail::to_bits(static_cast<_V>(detail::from_bits<_V>(value) + detail::from_bits<_V>(operand))); });
+	}
+
+	_V fetch_sub(const _V operand, const std::memory_order order = std::memory_order_seq_cst) requires std::is_integral_v<_V> {
+		return this->apply(order, operand, [](const uint64_t value, const uint64_t operand) { return detail::to_bits(static_cast<_V>(detail::from_bits<_V>(value) - detail::from_bits<_V>(operand))); });
+	}
+
+	_V fetch_and(const _V operand, const std::memory_order order = std::memory_order_seq_cst) requires std::is_integral_v<_V> {
+		return this->apply(order, operand, [](const uint64_t value, const uint64_t operand) { return value & operand; });
+	}
+
+	_V fetch_or(const _V operand, const std::memory_order order = std::memory_order_seq_cst) requires std::is_integral_v<_V> {
+		return this->apply(order, operand, [](const uint64_t value, const uint64_t operand) { return value | operand; });
+	}
+
+	_V fetch_xor(const _V operand, const std::memory_order order = std::memory_order_seq_cst) requires std::is_integral_v<_V> {
+		return this->apply(order, operand, [](const uint64_t value, const uint64_t operand) { return value ^ operand; });
+	}
+
+	operator _V() const {
+		return this->load();
+	}
+
+	_V operator=(const _V value) {
+		this->store(value);
+		return value;
+	}
+
+private:
+	static constexpr std::memory_order failure_order(const std::memory_order order) noexcept {
+		if (order == std::memory_order_acq_rel) {
+			return std::memory_order_acquire;
+		}
+
+		if (order == std::memory_order_release) {
+			return std::memory_order_relaxed;
+		}
+
+		return order;
+	}
+
+	_V apply(const std::memory_order order, const _V operand, uint64_t (*op)(uint64_t, uint64_t)) {
+		return detail::from_bits<_V>(this->location.read_modify_write(order, op, detail::to_bits(operand)));
+	}
+
+	mutable detail::AtomicLocation location;
+};
+
+/*
+ * Plain, non-atomic data shared between the threads of a test. Every access
+ * is checked for data races against every other thread.
+ */
+template <typename _V>
+class Var {
+public:
+	Var() :
+			value()
+	{ }
+
+	Var(const _V& value) :
+			value(value)
+	{ }
+
+	Var(const Var& other) :
+			value(other.get())
+	{ }
+
+	/**
+	 * @brief Destroying a Var counts as a write, so freeing it while another thread may still read it is a data race
+	 */
+	~Var() {
+		this->location.on_write();
+	}
+
+	Var& operator=(const Var& other) {
+		this->set(other.get());
+		return *this;
+	}
+
+	Var& operator=(const _V& value) {
+		this->set(value);
+		return *this;
+	}
+
+	/**
+	 * @brief Read the value
+	 * @return Value of the variable
+	 */
+	_V get() const {
+		this->location.on_read();
+		return this->value;
+	}
+
+	/**
+	 * @brief Write the value
+	 * @param value New value of the variable
+	 */
+	void set(const _V& value) {
+		this->location.on_write();
+		this->value = value;
+	}
+
+	operator _V() const {
+		return this->get();
+	}
+
+private:
+	_V                           value;
+	mutable detail::DataLocation location;
+};
+
+/**
+ * @brief Explore the executions of _Test
+ * @note _Test must have a static THREADS no larger than MAX_THREADS, a thread(size_t index) member run on every thread and a finish() member run after them. A fresh _Test is constructed for every execution
+ * @param options Limits of the exploration
+ * @return Number of executions explored and the first failure, if any
+ */
+template <typename _Test>
+CheckReport check_model(const CheckOptions& options = CheckOptions()) {
+	std::unique_ptr<_Test> test;
+
+	return detail::explore(options, _Test::THREADS,
+		[&] { test = std::make_unique<_Test>(); },
+		[&](const size_t index) { test->thread(index); },
+		[&] {
+			test->finish();
+			test.reset();
+		});
+}
+
+/// Queue traits that swap the atomics of SpscQueue for model::Atomic
+struct ModelQueueTraits : DefaultQueueTraits {
+	template <typename _V>
+	using atomic_type = Atomic<_V>;
+};
+} // namespace lfmq::model
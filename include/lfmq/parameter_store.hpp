@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "cache_line.hpp"
+#include "queue_policies.hpp"
+
+namespace lfmq
+{
+/*
+ * Preallocated table of continuous parameters such as volume or effect mix,
+ * as an alternative to sending every change as a message. The controller
+ * sets a parameter with a relaxed store of its value and marks the cache
+ * line holding it as dirty in a bitset. Once per block the audio thread
+ * takes the whole bitset with one exchange per 64 groups and reads only the
+ * dirty groups, so high rate parameter changes never touch a message queue
+ * and unchanged parameters cost nothing.
+ *
+ * Values are grouped GROUP_SIZE to a cache line. Every parameter holds its
+ * latest value; intermediate values set between two blocks are skipped,
+ * which is what a continuous parameter wants. Only the atomic_type of
+ * _Traits is used, so model::ModelQueueTraits runs the store under the model
+ * checker.
+ */
+template <typename _V, size_t _count, typename _Traits = DefaultQueueTraits> requires std::is_arithmetic_v<_V> && (_count > 0)
+class ParameterStore {
+public:
+	using value_type = typename _Traits::template atomic_type<_V>;
+	using word_type  = typename _Traits::template atomic_type<uint64_t>;
+
+	static_assert(value_type::is_always_lock_free, "parameters must be lock-free atomics");
+
+	/// Number of parameters sharing a cache line, and a dirty bit
+	static constexpr size_t GROUP_SIZE = CACHE_LINE_SIZE / sizeof(_V);
+	static constexpr size_t GROUPS     = (_count + GROUP_SIZE - 1) / GROUP_SIZE;
+	static constexpr size_t WORDS      = (GROUPS + 63) / 64;
+
+	ParameterStore() = default;
+	ParameterStore(const ParameterStore&) = delete;
+	ParameterStore& operator=(const ParameterStore&) = delete;
+
+	/**
+	 * @brief Set the value of a parameter
+	 * @note Wait-free. May be called from any number of threads, the audio thread sees the value by its next for_each_changed
+	 * @param index Index of the parameter, less than size()
+	 * @param value New value of the parameter
+	 */
+	void set(const size_t index, const _V value) noexcept {
+		const size_t group = index / GROUP_SIZE;
+
+		this->groups[group].values[index % GROUP_SIZE].store(value, std::memory_order_relaxed);
+		// release so that whoever takes the dirty bit sees the value stored above
+		this->dirty[group / 64].fetch_or(uint64_t{ 1 } << (group % 64), std::memory_order_release);
+	}
+
+	/**
+	 * @brief Return the latest value of a parameter
+	 * @note May be called from any thread
+	 * @param index Index of the parameter, less than size()
+	 * @return Latest value of the parameter
+	 */
+	_V get(const size_t index) const noexcept {
+		return this->groups[index / GROUP_SIZE].values[index % GROUP_SIZE].load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Call fn(index, value) for every parameter whose value changed since the last call
+	 * @note Only call this from the audio thread. Allocation free, and only the groups marked dirty are read
+	 * @param fn Callable invoked with the index and the new value of each changed parameter
+	 * @return Number of parameters that changed
+	 */
+	template<typename _F>
+	size_t for_each_changed(_F&& fn) {
+		size_t changed = 0;
+
+		for (size_t word = 0; word < WORDS; word++) {
+			// cheap relaxed check first, so idle words are never written to
+			if (this->dirty[word].load(std::memory_order_relaxed) == 0) {
+				continue;
+			}
+
+			uint64_t bits = this->dirty[word].exchange(0, std::memory_order_acquire);
+
+			while (bits != 0) {
+				const size_t group = word * 64 + static_cast<size_t>(std::countr_zero(bits));
+				bits &= bits - 1;
+
+				const size_t first = group * GROUP_SIZE;
+				const size_t last  = first + GROUP_SIZE < _count ? first + GROUP_SIZE : _count;
+
+				for (size_t index = first; index < last; index++) {
+					const _V value = this->groups[group].values[index - first].load(std::memory_order_relaxed);
+
+					// compared bitwise so that NaN and -0.0 count as changes too
+					if (std::memcmp(&value, &this->seen[index], sizeof(_V)) != 0) {
+						this->seen[index] = value;
+						fn(index, value);
+						changed++;
+					}
+				}
+			}
+		}
+
+		return changed;
+	}
+
+	/**
+	 * @brief Return whether any parameter was set since the last call to for_each_changed
+	 * @return Whether any group is marked dirty
+	 */
+	bool has_changes() const noexcept {
+		for (size_t word = 0; word < WORDS; word++) {
+			if (this->dirty[word].load(std::memory_order_relaxed) != 0) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/**
+	 * @brief Return the number of parameters
+	 * @return Number of parameters
+	 */
+	constexpr size_t size() const noexcept {
+		return _count;
+	}
+
+private:
+	struct alignas(CACHE_LINE_SIZE) Group {
+		value_type values[GROUP_SIZE] = {};
+	};
+
+	Group groups[GROUPS];
+
+	alignas(CACHE_LINE_SIZE) word_type dirty[WORDS] = {};
+
+	// last value handed to the audio thread, only touched by for_each_changed
+	alignas(CACHE_LINE_SIZE) _V seen[_count] = {};
+};
+} // namespace lfmq
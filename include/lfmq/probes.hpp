@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Linux SDT/USDT static tracepoints. When lfmq is configured with
+ * LFMQ_ENABLE_USDT=ON the probes below expand to <sys/sdt.h> markers, which
+ * are a single nop until bpftrace, perf or SystemTap attaches to them, for
+ * example:
+ *
+ *   bpftrace -e 'usdt:./app:lfmq:push_failed { @[arg3] = count(); }'
+ *
+ * Without LFMQ_ENABLE_USDT they expand to nothing and their arguments are
+ * never evaluated.
+ *
+ * Probes fired by SpscQueue, all in the "lfmq" provider:
+ *   push(queue, write_index, next_write_index, message_type)
+ *   push_failed(queue, write_index, read_index, message_type)
+ *   pop(queue, read_index, write_index, message_type)
+ * message_type is NO_MESSAGE_TYPE for elements that are not a Message.
+ */
+
+namespace lfmq
+{
+/// Message type reported for queue elements that are not a Message
+inline constexpr int16_t NO_MESSAGE_TYPE = -1;
+
+/**
+ * @brief Return the message type of a queue element, for tracing and probes. message.hpp overloads this for Message
+ * @param element Element of any type
+ * @return NO_MESSAGE_TYPE
+ */
+template<typename _T>
+constexpr int16_t element_message_type(const _T&) noexcept {
+	return NO_MESSAGE_TYPE;
+}
+} // namespace lfmq
+
+#if defined(LFMQ_ENABLE_USDT)
+#if !__has_include(<sys/sdt.h>)
+#error "LFMQ_ENABLE_USDT requires <sys/sdt.h> (systemtap-sdt-dev or systemtap-sdt-devel)"
+#endif
+
+#include <sys/sdt.h>
+
+#define LFMQ_PROBE4(name, arg1, arg2, arg3, arg4) DTRACE_PROBE4(lfmq, name, arg1, arg2, arg3, arg4)
+#else
+#define LFMQ_PROBE4(name, arg1, arg2, arg3, arg4) ((void)0)
+#endif
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "cache_line.hpp"
+#include "clock.hpp"
+#include "latency_histogram.hpp"
+
+namespace lfmq
+{
+/*
+ * Compile-time policies of SpscQueue. Every policy exposes a nested
+ * template that the queue instantiates with its capacity (or its element
+ * type, for the trace policy) and stores as a [[no_unique_address]] member,
+ * so a disabled policy is an empty type whose hooks are empty inline
+ * functions and compiles down to nothing.
+ *
+ * A queue picks its policies through a traits type. To enable a policy,
+ * derive from DefaultQueueTraits and override the alias, for example:
+ *
+ *   struct TimedTraits : lfmq::DefaultQueueTraits {
+ *       using latency_policy = lfmq::LatencyTracking<lfmq::TscClock>;
+ *       using stats_policy   = lfmq::QueueStats;
+ *       using trace_policy   = lfmq::MessageTracing; // trace.hpp
+ *       using storage_policy = lfmq::MappedStorage;  // ring_storage.hpp
+ *   };
+ *   lfmq::SpscQueue<lfmq::Message, 1024, TimedTraits> queue;
+ */
+
+/// Latency policy that records nothing
+struct NoLatencyTracking {
+	template <size_t _size>
+	struct Tracker {
+		void on_push(const size_t) noexcept { }
+		void on_pop(const size_t) noexcept { }
+	};
+};
+
+/*
+ * Latency policy that stamps every slot with _Clock::now() when it is
+ * pushed and records how long the element sat in the queue into a
+ * LatencyHistogram when it is popped. The histogram is in _Clock ticks.
+ */
+template <typename _Clock = SteadyClock>
+struct LatencyTracking {
+	template <size_t _size>
+	class Tracker {
+	public:
+		/**
+		 * @brief Stamp the slot at index with the current time
+		 * @note Called on the producer thread before the slot is published
+		 */
+		void on_push(const size_t index) noexcept {
+			this->stamps[index] = _Clock::now();
+		}
+
+		/**
+		 * @brief Record the time the element at index spent in the queue
+		 * @note Called on the consumer thread before the slot is released
+		 */
+		void on_pop(const size_t index) noexcept {
+			this->latency.record(_Clock::now() - this->stamps[index]);
+		}
+
+		/**
+		 * @brief Return the histogram of time spent in the queue, in _Clock ticks
+		 * @return Histogram of time spent in the queue
+		 */
+		const LatencyHistogram& histogram() const noexcept {
+			return this->latency;
+		}
+
+		/**
+		 * @brief Return the histogram of time spent in the queue, in _Clock ticks
+		 * @return Histogram of time spent in the queue
+		 */
+		LatencyHistogram& histogram() noexcept {
+			return this->latency;
+		}
+
+	private:
+		uint64_t         stamps[_size] = {};
+		LatencyHistogram latency;
+	};
+};
+
+/*
+ * Point in time view of the statistics of a queue
+ */
+struct QueueStatsSnapshot {
+	uint64_t pushes         = 0; // Successful pushes
+	uint64_t failed_pushes  = 0; // Pushes that returned false because the queue was full
+	uint64_t pops           = 0; // Successful pops
+	uint64_t high_watermark = 0; // Highest number of elements the queue has held at once
+	uint64_t occupancy      = 0; // Number of elements in the queue when the snapshot was taken
+};
+
+/// Statistics policy that counts nothing
+struct NoQueueStats {
+	template <size_t _size>
+	struct Recorder {
+		void on_push(const size_t) noexcept { }
+		void on_push_failed() noexcept { }
+		void on_pop() noexcept { }
+
+		QueueStatsSnapshot snapshot() const noexcept {
+			return QueueStatsSnapshot();
+		}
+	};
+};
+
+/*
+ * Statistics policy that counts pushes, failed pushes and pops and tracks the
+ * high watermark of the occupancy. Each side only writes counters on its own
+ * cache line, with relaxed loads and stores since every counter has a single
+ * writer, so recording adds no cross-core traffic. snapshot may be called
+ * from any thread. Elements pushed onto a Frame are counted when they are
+ * staged, whether or not the frame is committed.
+ */
+struct QueueStats {
+	template <size_t _size>
+	class Recorder {
+	public:
+		/**
+		 * @brief Count a successful push
+		 * @note Called on the producer thread
+		 * @param occupancy Number of elements in the queue including the pushed one
+		 */
+		void on_push(const size_t occupancy) noexcept {
+			increment(this->producer.pushes);
+
+			if (occupancy > this->producer.high_watermark.load(std::memory_order_relaxed)) {
+				this->producer.high_watermark.store(occupancy, std::memory_order_relaxed);
+			}
+		}
+
+		/**
+		 * @brief Count a push that failed because the queue was full
+		 * @note Called on the producer thread
+		 */
+		void on_push_failed() noexcept {
+			increment(this->producer.failed_pushes);
+		}
+
+		/**
+		 * @brief Count a successful pop
+		 * @note Called on the consumer thread
+		 */
+		void on_pop() noexcept {
+			increment(this->consumer.pops);
+		}
+
+		/**
+		 * @brief Read every counter
+		 * @return Counters at roughly the time of the call. occupancy is left to the queue to fill in
+		 */
+		QueueStatsSnapshot snapshot() const noexcept {
+			QueueStatsSnapshot snapshot;
+
+			snapshot.pushes         = this->producer.pushes.load(std::memory_order_relaxed);
+			snapshot.failed_pushes  = this->producer.failed_pushes.load(std::memory_order_relaxed);
+			snapshot.high_watermark = this->producer.high_watermark.load(std::memory_order_relaxed);
+			snapshot.pops           = this->consumer.pops.load(std::memory_order_relaxed);
+
+			return snapshot;
+		}
+
+	private:
+		static void increment(std::atomic<uint64_t>& counter) noexcept {
+			counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+
+		struct alignas(CACHE_LINE_SIZE) ProducerCounters {
+			std::atomic<uint64_t> pushes         = 0;
+			std::atomic<uint64_t> failed_pushes  = 0;
+			std::atomic<uint64_t> high_watermark = 0;
+		};
+
+		struct alignas(CACHE_LINE_SIZE) ConsumerCounters {
+			std::atomic<uint64_t> pops = 0;
+		};
+
+		ProducerCounters producer;
+		ConsumerCounters consumer;
+	};
+};
+
+/// Trace policy that records nothing. MessageTracing in trace.hpp records push and pop events
+struct NoTracing {
+	template <typename _T>
+	struct Recorder {
+		void on_push(const _T&) noexcept { }
+		void on_push_failed(const _T&) noexcept { }
+		void on_pop(const _T&) noexcept { }
+	};
+};
+
+/// Storage policy that keeps the ring inside the queue object. MappedStorage in ring_storage.hpp maps it on huge pages instead
+struct InlineStorage {
+	template <typename _T, size_t _size>
+	struct Storage {
+		_T& operator[](const size_t index) noexcept {
+			return this->elements[index];
+		}
+
+		const _T& operator[](const size_t index) const noexcept {
+			return this->elements[index];
+		}
+
+		_T elements[_size];
+	};
+};
+
+/// Policies used by SpscQueue unless told otherwise
+struct DefaultQueueTraits {
+	using latency_policy = NoLatencyTracking;
+	using stats_policy   = NoQueueStats;
+	using trace_policy   = NoTracing;
+	using storage_policy = InlineStorage;
+
+	/// Atomic the indices are stored in. model::ModelQueueTraits swaps it for the model checker's instrumented atomic
+	template <typename _V>
+	using atomic_type = std::atomic<_V>;
+};
+} // namespace lfmq
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "cache_line.hpp"
+#include "queue_policies.hpp"
+
+namespace lfmq
+{
+/*
+ * Read-copy-update of an immutable snapshot shared by the controller and a
+ * single real-time reader, such as the audio thread's effect chain. Instead
+ * of sending EFFECT_ADDED, EFFECT_REMOVED, EFFECT_ENABLED and
+ * EFFECT_DISABLED messages that edit the chain one step at a time, the
+ * controller builds a complete new chain off the real-time thread and
+ * publishes it with a single pointer exchange. The reader picks up the
+ * latest snapshot at every block boundary with one store and one load.
+ *
+ * Every call to read is a quiescent state of the reader: it drops the
+ * snapshot returned by the previous call. A replaced snapshot is retired with
+ * the number of quiescent states the reader had gone through, and the
+ * controller deletes it once the reader has gone through another one, so the
+ * reader never frees or waits for anything. Both sides use seq_cst for the
+ * counter and the pointer; that ordering is what guarantees the controller
+ * either sees that the reader started a block or that the reader sees the
+ * new snapshot. The bench "model" scenario checks this.
+ *
+ * Only the atomic_type of _Traits is used, so model::ModelQueueTraits runs
+ * the snapshot under the model checker.
+ */
+template <typename _T, typename _Traits = DefaultQueueTraits>
+class RcuSnapshot {
+public:
+	/**
+	 * @param initial Snapshot returned by read until the first publish. Must not be nullptr
+	 */
+	explicit RcuSnapshot(std::unique_ptr<_T> initial) :
+			current(initial.release())
+	{ }
+
+	RcuSnapshot(const RcuSnapshot&) = delete;
+	RcuSnapshot& operator=(const RcuSnapshot&) = delete;
+
+	/**
+	 * @brief Delete the current snapshot and every retired one
+	 * @note Only destroy the RcuSnapshot once the reader no longer calls read
+	 */
+	~RcuSnapshot() {
+		for (const Retired& retired : this->retired) {
+			delete retired.snapshot;
+		}
+
+		delete this->current.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Return the latest snapshot and drop the one returned by the previous call
+	 * @note Only call this from the reader thread, once per block. Wait-free
+	 * @return Latest published snapshot, valid until the next call to read
+	 */
+	const _T* read() noexcept {
+		this->reader.local++;
+		this->reader.blocks.store(this->reader.local, std::memory_order_seq_cst);
+
+		return this->current.load(std::memory_order_seq_cst);
+	}
+
+	/**
+	 * @brief Make snapshot the one the reader gets from its next read, and delete the snapshots the reader is done with
+	 * @note Only call this from the controller thread. Allocates and frees, never call it from a real-time thread
+	 * @param snapshot Complete new snapshot. Must not be nullptr
+	 */
+	void publish(std::unique_ptr<_T> snapshot) {
+		_T* const previous = this->current.exchange(snapshot.release(), std::memory_order_seq_cst);
+
+		// the reader may still use previous until it gets past the block it is in now
+		this->retired.push_back(Retired{ previous, this->reader.blocks.load(std::memory_order_seq_cst) });
+
+		this->reclaim();
+	}
+
+	/**
+	 * @brief Delete every retired snapshot the reader has moved past
+	 * @note Only call this from the controller thread, for example periodically when nothing gets published
+	 * @return Number of snapshots deleted
+	 */
+	size_t reclaim() {
+		const uint64_t blocks = this->reader.blocks.load(std::memory_order_acquire);
+		size_t         count  = 0;
+
+		std::erase_if(this->retired, [&](const Retired& retired) {
+			if (retired.blocks >= blocks) {
+				return false;
+			}
+
+			delete retired.snapshot;
+			count++;
+
+			return true;
+		});
+
+		return count;
+	}
+
+	/**
+	 * @brief Return the snapshot that was published last
+	 * @note Only call this from the controller thread
+	 * @return Snapshot that was published last
+	 */
+	const _T* latest() const noexcept {
+		return this->current.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Return the number of snapshots waiting for the reader to move past them
+	 * @note Only call this from the controller thread
+	 * @return Number of retired snapshots that have not been deleted
+	 */
+	size_t retired_count() const noexcept {
+		return this->retired.size();
+	}
+
+private:
+	struct Retired {
+		_T*      snapshot = nullptr;
+		uint64_t blocks   = 0; // Quiescent states of the reader when snapshot was replaced
+	};
+
+	// written by the reader every block, so kept away from the pointer the controller writes
+	struct alignas(CACHE_LINE_SIZE) ReaderSide {
+		typename _Traits::template atomic_type<uint64_t> blocks = 0; // Quiescent states, published to the controller
+		uint64_t                                         local  = 0; // Same count, kept by the reader without atomics
+	};
+
+	alignas(CACHE_LINE_SIZE) typename _Traits::template atomic_type<_T*> current;
+
+	ReaderSide reader;
+
+	std::vector<Retired> retired;
+};
+} // namespace lfmq
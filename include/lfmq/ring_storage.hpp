@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace lfmq
+{
+/*
+ * Kind of pages a MappedStorage ring ended up on, from best to worst
+ */
+enum class RingPages : uint8_t {
+	HUGETLB,          // Explicit huge pages from the pool reserved in /proc/sys/vm/nr_hugepages
+	TRANSPARENT_HUGE, // Regular mapping aligned to the huge page size and advised to use transparent huge pages
+	REGULAR           // Regular pages
+};
+
+/**
+ * @brief Return the name of a page kind, such as "hugetlb"
+ * @param pages Page kind
+ * @return Name of the page kind
+ */
+const char* ring_pages_name(RingPages pages) noexcept;
+
+namespace detail
+{
+struct MappedRing {
+	void*     address = nullptr;
+	size_t    length  = 0;
+	RingPages pages   = RingPages::REGULAR;
+	bool      locked  = false;
+};
+
+/**
+ * @brief Map at least bytes of zeroed memory on the largest pages available, touch every page and lock the range
+ * @return Mapping, locked unless RLIMIT_MEMLOCK is too low
+ * @throws std::bad_alloc if not even regular pages could be mapped
+ */
+MappedRing map_ring(size_t bytes);
+
+void unmap_ring(const MappedRing& ring) noexcept;
+} // namespace detail
+
+/*
+ * Storage policy of SpscQueue that maps the ring on its own instead of
+ * keeping it inside the queue object. A SpscQueue<Message, 4096> spans
+ * hundreds of 4 KiB pages, so the first lap around an inline ring takes a
+ * page fault on every page and keeps missing the TLB afterwards.
+ *
+ * A ring of at least one huge page is mapped on explicit huge pages when the
+ * system has a pool of them, and otherwise on a huge page aligned mapping
+ * advised to use transparent huge pages. Smaller rings go on regular pages,
+ * so that they never take a whole page out of the reserved pool. Every page
+ * is written and the range is locked with mlock while the queue is
+ * constructed, so neither side ever takes a page fault. A failed mlock,
+ * usually because of RLIMIT_MEMLOCK, is not fatal and shows up in is_locked.
+ *
+ *   struct PinnedTraits : lfmq::DefaultQueueTraits {
+ *       using storage_policy = lfmq::MappedStorage;
+ *   };
+ *   auto queue = std::make_unique<lfmq::SpscQueue<lfmq::Message, 4096, PinnedTraits>>();
+ *
+ * Constructing and destroying the queue makes system calls, so do both off
+ * the real-time thread.
+ */
+struct MappedStorage {
+	template <typename _T, size_t _size>
+	class Storage {
+	public:
+		/**
+		 * @throws std::bad_alloc if the ring could not be mapped
+		 */
+		Storage() :
+				ring(detail::map_ring(sizeof(_T) * _size)),
+				elements(static_cast<_T*>(this->ring.address))
+		{
+			try {
+				std::uninitialized_default_construct_n(this->elements, _size);
+			} catch (...) {
+				detail::unmap_ring(this->ring);
+				throw;
+			}
+		}
+
+		~Storage() {
+			std::destroy_n(this->elements, _size);
+			detail::unmap_ring(this->ring);
+		}
+
+		Storage(const Storage&) = delete;
+		Storage& operator=(const Storage&) = delete;
+
+		_T& operator[](const size_t index) noexcept {
+			return this->elements[index];
+		}
+
+		const _T& operator[](const size_t index) const noexcept {
+			return this->elements[index];
+		}
+
+		/**
+		 * @brief Return the kind of pages the ring is mapped on
+		 * @return Kind of pages the ring is mapped on
+		 */
+		RingPages pages() const noexcept {
+			return this->ring.pages;
+		}
+
+		/**
+		 * @brief Return whether the ring is locked into memory
+		 * @return Whether mlock succeeded
+		 */
+		bool is_locked() const noexcept {
+			return this->ring.locked;
+		}
+
+		/**
+		 * @brief Return the number of bytes mapped for the ring, including the rounding up to whole pages
+		 * @return Number of bytes mapped
+		 */
+		size_t mapped_bytes() const noexcept {
+			return this->ring.length;
+		}
+
+	private:
+		detail::MappedRing ring;
+		_T*                elements;
+	};
+};
+} // namespace lfmq
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace lfmq
+{
+/*
+ * Where two CPUs sit relative to each other, from closest to farthest. The
+ * cost of moving a cache line between the producer and the consumer of a
+ * queue grows with every step.
+ */
+enum class CpuDistance : uint8_t {
+	SAME_CPU,      // The same logical CPU
+	SMT_SIBLING,   // Hyperthreads of one physical core, sharing its L1 and L2
+	SHARED_L2,     // Different cores sharing an L2, as in a core cluster
+	SHARED_L3,     // Different cores sharing the last level cache
+	SAME_PACKAGE,  // Same socket without a shared cache, such as different CCXs
+	CROSS_PACKAGE  // Different sockets
+};
+
+/**
+ * @brief Return the name of a CPU distance, such as "shared_l3"
+ * @param distance CPU distance
+ * @return Name of the distance
+ */
+const char* cpu_distance_name(CpuDistance distance) noexcept;
+
+/*
+ * Cache and core topology of the CPUs the process may run on. CPUs are
+ * grouped by the lowest CPU sharing the same core, L2, L3 and package, so
+ * comparing two groups tells whether two CPUs share them.
+ */
+class CpuTopology {
+public:
+	/*
+	 * Placement of a single logical CPU. Groups are -1 when sysfs does not
+	 * describe them.
+	 */
+	struct Cpu {
+		int cpu     = -1;
+		int core    = -1; // Lowest CPU of the physical core
+		int l2      = -1; // Lowest CPU sharing the L2
+		int l3      = -1; // Lowest CPU sharing the L3
+		int package = -1; // Physical package id
+	};
+
+	/**
+	 * @brief Read the topology of every CPU the calling thread may run on from /sys/devices/system/cpu
+	 * @note Allocates and reads files, never call this from a real-time thread
+	 * @return Topology, with ungrouped CPUs if sysfs is not available
+	 */
+	static CpuTopology read();
+
+	/**
+	 * @brief Return every CPU of the topology, ordered by CPU number
+	 * @return Every CPU of the topology
+	 */
+	const std::vector<Cpu>& cpus() const noexcept {
+		return this->entries;
+	}
+
+	/**
+	 * @brief Return where two CPUs sit relative to each other
+	 * @param a First CPU
+	 * @param b Second CPU
+	 * @return Distance between a and b, CROSS_PACKAGE if either is not part of the topology
+	 */
+	CpuDistance distance(int a, int b) const noexcept;
+
+	/**
+	 * @brief Pick the pair of CPUs on different physical cores that share the closest cache, for the two ends of a queue
+	 * @note SMT siblings are only picked if there is a single physical core, and the same CPU twice if there is a single CPU
+	 * @param first Assigned the CPU of one end
+	 * @param second Assigned the CPU of the other end
+	 * @return Distance between the two CPUs
+	 */
+	CpuDistance closest_pair(int& first, int& second) const noexcept;
+
+private:
+	const Cpu* find(int cpu) const noexcept;
+
+	std::vector<Cpu> entries;
+};
+
+/**
+ * @brief Return the CPUs the calling thread may run on
+ * @return CPUs the calling thread may run on, never empty
+ */
+std::vector<int> allowed_cpus();
+
+/**
+ * @brief Pin the calling thread to a CPU
+ * @param cpu CPU to pin the calling thread to. Negative values leave the thread unpinned
+ * @return Whether the thread is running where it was asked to
+ */
+bool pin_this_thread(int cpu);
+
+/**
+ * @brief Switch the calling thread to the SCHED_FIFO real-time policy
+ * @note Needs CAP_SYS_NICE or an RLIMIT_RTPRIO of at least priority. A SCHED_FIFO thread that spins without blocking starves everything else on its CPU
+ * @param priority SCHED_FIFO priority, clamped to the range supported by the system. 0 or less switches back to SCHED_OTHER
+ * @return Whether the policy was applied
+ */
+bool set_realtime_priority(int priority);
+} // namespace lfmq
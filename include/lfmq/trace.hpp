@@ -0,0 +1,147 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "message.hpp"
+
+namespace lfmq
+{
+/*
+ * Message lifecycle tracing. Threads record compact events into their own
+ * lock-free ring buffer, and a TraceWriter thread drains every ring and
+ * serializes the events to a Chrome trace event JSON file, which both
+ * chrome://tracing and the Perfetto UI open. Recording an event is a clock
+ * read and an SpscQueue push; real-time threads never format or write
+ * anything themselves.
+ *
+ * Events are only recorded while a TraceWriter is running, so leaving the
+ * hooks in place costs a single relaxed load when tracing is off.
+ */
+
+enum class TraceEventKind : uint8_t {
+	PUSH,        // An element was pushed onto a queue
+	PUSH_FAILED, // A push failed because the queue was full
+	POP,         // An element was popped off of a queue
+	DISPATCH     // A message was handed to its handler
+};
+
+/// Number of events each thread can buffer before the writer drains them
+inline constexpr size_t TRACE_BUFFER_SIZE = 16384;
+
+namespace detail
+{
+extern std::atomic<bool> trace_enabled;
+
+void record_trace_event(TraceEventKind kind, uint32_t queue_id, int16_t message_type) noexcept;
+} // namespace detail
+
+/**
+ * @brief Return whether a TraceWriter is currently collecting events
+ * @return Whether a TraceWriter is currently collecting events
+ */
+inline bool is_tracing() noexcept {
+	return detail::trace_enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Allocate the trace buffer of the calling thread and give the thread a name in the trace
+ * @note Real-time threads must call this before entering their real-time loop, since the first event of an unregistered thread allocates its buffer
+ * @param name Name of the thread shown in the trace viewer. Copied
+ */
+void register_trace_thread(const char* name);
+
+/**
+ * @brief Record an event into the trace buffer of the calling thread. Dropped if the buffer is full
+ * @param kind What happened
+ * @param queue_id Id of the queue the event happened on
+ * @param message_type Type of the message, NO_MESSAGE_TYPE if the element is not a Message
+ */
+inline void trace_event(const TraceEventKind kind, const uint32_t queue_id, const int16_t message_type = NO_MESSAGE_TYPE) noexcept {
+	if (is_tracing()) {
+		detail::record_trace_event(kind, queue_id, message_type);
+	}
+}
+
+/*
+ * Background thread that drains the trace buffers of every registered
+ * thread and writes the events to a file in the Chrome trace event format.
+ * Only one writer can run at a time.
+ */
+class TraceWriter {
+public:
+	TraceWriter();
+	TraceWriter(const TraceWriter&) = delete;
+	TraceWriter& operator=(const TraceWriter&) = delete;
+
+	/**
+	 * @brief Stop the writer if it is still running
+	 */
+	~TraceWriter();
+
+	/**
+	 * @brief Open path and start collecting events
+	 * @param path File to write the trace to. Truncated if it exists
+	 * @param flush_interval How often the trace buffers are drained
+	 * @return True if the writer started, false if the file could not be opened or another writer is running
+	 */
+	bool start(const char* path, std::chrono::milliseconds flush_interval = std::chrono::milliseconds(20));
+
+	/**
+	 * @brief Stop collecting events, drain what is left and close the file
+	 */
+	void stop();
+
+	/**
+	 * @brief Return the number of events written so far, or by the last run once stopped
+	 * @return Number of events written
+	 */
+	uint64_t events_written() const noexcept;
+
+private:
+	struct State;
+
+	std::unique_ptr<State> state;
+	uint64_t               last_written = 0;
+};
+
+/*
+ * Trace policy for SpscQueue that records push, failed push and pop events,
+ * tagged with the queue id and the message type of the element
+ */
+struct MessageTracing {
+	template <typename _T>
+	class Recorder {
+	public:
+		/**
+		 * @brief Set the id the events of the queue are tagged with
+		 * @param id Id of the queue, shown in the trace viewer
+		 */
+		void set_queue_id(const uint32_t id) noexcept {
+			this->queue_id = id;
+		}
+
+		uint32_t get_queue_id() const noexcept {
+			return this->queue_id;
+		}
+
+		void on_push(const _T& element) noexcept {
+			trace_event(TraceEventKind::PUSH, this->queue_id, element_message_type(element));
+		}
+
+		void on_push_failed(const _T& element) noexcept {
+			trace_event(TraceEventKind::PUSH_FAILED, this->queue_id, element_message_type(element));
+		}
+
+		void on_pop(const _T& element) noexcept {
+			trace_event(TraceEventKind::POP, this->queue_id, element_message_type(element));
+		}
+
+	private:
+		uint32_t queue_id = 0;
+	};
+};
+} // namespace lfmq
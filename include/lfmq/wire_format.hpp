@@ -0,0 +1,215 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "message.hpp"
+
+namespace lfmq
+{
+/*
+ * Binary wire format for streams of messages. Every message is encoded as a
+ * little-endian record:
+ *
+ *   offset  size  field
+ *   0       1     format version (WIRE_FORMAT_VERSION)
+ *   1       1     flags (WIRE_FLAG_*)
+ *   2       2     MessageType
+ *   4       4     payload size in bytes
+ *   8       8     frame time, only present if WIRE_FLAG_FRAME_TIME is set
+ *   ...     4     correlation id, only present if WIRE_FLAG_CORRELATION_ID is set
+ *   ...           exactly payload size bytes of payload
+ *
+ * Records are simply concatenated, so a stream can be captured to a file or
+ * written to a pipe as is. Neither encoding nor decoding allocates; decoding
+ * produces a MessageView that points into the source buffer.
+ */
+
+/// Version written into, and required from, every record header
+inline constexpr uint8_t WIRE_FORMAT_VERSION = 1;
+
+/// The record carries a frame time after the fixed header
+inline constexpr uint8_t WIRE_FLAG_FRAME_TIME = 0x01;
+
+/// The record carries a correlation id after the frame time
+inline constexpr uint8_t WIRE_FLAG_CORRELATION_ID = 0x02;
+
+/// Size in bytes of the fixed part of every record header
+inline constexpr size_t WIRE_HEADER_SIZE = 8;
+
+/// Size in bytes of the largest possible record
+inline constexpr size_t WIRE_MAX_RECORD_SIZE = WIRE_HEADER_SIZE + sizeof(uint64_t) + sizeof(uint32_t) + Message::MAX_MESSAGE_SIZE;
+
+enum class WireStatus {
+	OK,                  // A record was decoded
+	TRUNCATED,           // The buffer ends before the end of the record. More bytes are needed
+	UNSUPPORTED_VERSION, // The record was written with a different version of the format
+	MALFORMED            // The record header is invalid
+};
+
+struct DecodeResult {
+	WireStatus status;
+	size_t     size; // Size in bytes of the decoded record, 0 unless status is OK
+};
+
+/*
+ * Zero-copy view of a decoded message. The payload points into the buffer
+ * the message was decoded from, so the view must not outlive that buffer.
+ */
+class MessageView {
+private:
+	MessageMetadata            metadata;
+	std::span<const std::byte> payload;
+
+public:
+	constexpr MessageView() noexcept = default;
+
+	constexpr MessageView(const MessageMetadata& metadata, const std::span<const std::byte> payload) noexcept :
+			metadata(metadata),
+			payload(payload)
+	{ }
+
+	constexpr const MessageMetadata& get_metadata() const noexcept {
+		return this->metadata;
+	}
+
+	constexpr std::span<const std::byte> get_payload() const noexcept {
+		return this->payload;
+	}
+
+	/**
+	 * @brief Copy the payload out as a _T
+	 * @note The payload in the source buffer is not necessarily aligned for _T, so it is copied rather than referenced
+	 * @param value Value to copy the payload into. Will not be modified if this returns false
+	 * @return True if the payload was copied, false if the payload is smaller than _T
+	 */
+	template<typename _T> requires std::is_trivially_copyable_v<_T>
+	bool get_payload(_T& value) const noexcept {
+		if (this->payload.size() < sizeof(_T)) {
+			return false;
+		}
+
+		memcpy(&value, this->payload.data(), sizeof(_T));
+
+		return true;
+	}
+
+	constexpr size_t get_payload_size() const noexcept {
+		return this->payload.size();
+	}
+};
+
+/**
+ * @brief Return the number of bytes message occupies on the wire
+ * @param message Message to be measured
+ * @return Number of bytes message occupies on the wire
+ */
+size_t wire_size(const Message& message) noexcept;
+
+/**
+ * @brief Encode message into the start of buffer
+ * @param message Message to be encoded
+ * @param buffer Destination of the record
+ * @return Number of bytes written, 0 if buffer is too small to hold the record. buffer is not modified if this returns 0
+ */
+size_t encode_message(const Message& message, std::span<std::byte> buffer) noexcept;
+
+/**
+ * @brief Decode the record at the start of buffer
+ * @param buffer Source of the record
+ * @param view View to point at the decoded message. Will not be modified unless the status is OK
+ * @return Status of the decode along with the size of the record that was consumed
+ */
+DecodeResult decode_message(std::span<const std::byte> buffer, MessageView& view) noexcept;
+
+/*
+ * Appends records to the end of a caller provided buffer
+ */
+class WireWriter {
+private:
+	std::span<std::byte> buffer;
+	size_t               offset;
+
+public:
+	constexpr explicit WireWriter(const std::span<std::byte> buffer) noexcept :
+			buffer(buffer),
+			offset(0)
+	{ }
+
+	/**
+	 * @brief Append message to the buffer
+	 * @param message Message to be appended
+	 * @return Whether the message was appended, false if the buffer does not have enough room left
+	 */
+	bool write(const Message& message) noexcept {
+		const size_t size = encode_message(message, this->buffer.subspan(this->offset));
+		this->offset += size;
+
+		return size > 0;
+	}
+
+	/**
+	 * @brief Return the records written so far
+	 * @return Records written so far
+	 */
+	constexpr std::span<const std::byte> written() const noexcept {
+		return this->buffer.first(this->offset);
+	}
+
+	/**
+	 * @brief Forget every record written so far, allowing the buffer to be reused
+	 */
+	constexpr void reset() noexcept {
+		this->offset = 0;
+	}
+};
+
+/*
+ * Iterates over the records in a buffer
+ */
+class WireReader {
+private:
+	std::span<const std::byte> buffer;
+	size_t                     offset;
+	WireStatus                 last_status;
+
+public:
+	constexpr explicit WireReader(const std::span<const std::byte> buffer) noexcept :
+			buffer(buffer),
+			offset(0),
+			last_status(WireStatus::OK)
+	{ }
+
+	/**
+	 * @brief Decode the next record
+	 * @param view View to point at the decoded message. Will not be modified if this returns false
+	 * @return True if a record was decoded, false at the end of the buffer or on an error. See status()
+	 */
+	bool next(MessageView& view) noexcept {
+		const DecodeResult result = decode_message(this->buffer.subspan(this->offset), view);
+
+		this->last_status = result.status;
+		this->offset += result.size;
+
+		return result.status == WireStatus::OK;
+	}
+
+	/**
+	 * @brief Return the status of the last call to next
+	 * @return Status of the last call to next. TRUNCATED with remaining() == 0 means the buffer was consumed exactly
+	 */
+	constexpr WireStatus status() const noexcept {
+		return this->last_status;
+	}
+
+	/**
+	 * @brief Return the number of bytes after the last decoded record
+	 * @return Number of bytes after the last decoded record
+	 */
+	constexpr size_t remaining() const noexcept {
+		return this->buffer.size() - this->offset;
+	}
+};
+} // namespace lfmq
@@ -0,0 +1,30 @@
+#include "clock.hpp"
+
+#include <thread>
+
+namespace lfmq
+{
+/*
+ * Start TscClock struct definitions
+ */
+#if defined(__x86_64__) || defined(__i386__)
+double TscClock::ticks_per_second() noexcept {
+	static const double frequency = [] {
+		const uint64_t start_ns    = SteadyClock::now();
+		const uint64_t start_ticks = TscClock::now();
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+		const uint64_t end_ticks = TscClock::now();
+		const uint64_t end_ns    = SteadyClock::now();
+
+		return static_cast<double>(end_ticks - start_ticks) * 1e9 / static_cast<double>(end_ns - start_ns);
+	}();
+
+	return frequency;
+}
+#endif
+/*
+ * End TscClock struct definitions
+ */
+} // namespace lfmq
@@ -0,0 +1,58 @@
+#include "event_notifier.hpp"
+
+#include <cstdint>
+
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+
+namespace lfmq
+{
+/*
+ * Start EventNotifier class definitions
+ */
+EventNotifier::~EventNotifier() {
+	this->close();
+}
+
+bool EventNotifier::open() {
+	if (this->event_fd != -1) {
+		return true;
+	}
+
+#if defined(__linux__)
+	this->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+
+	this->armed.store(true, std::memory_order_relaxed);
+
+	return this->event_fd != -1;
+}
+
+void EventNotifier::close() {
+	if (this->event_fd != -1) {
+		::close(this->event_fd);
+		this->event_fd = -1;
+	}
+}
+
+void EventNotifier::consume() noexcept {
+	uint64_t count = 0;
+
+	// non-blocking, so this only fails with EAGAIN when nothing was signalled
+	(void)!read(this->event_fd, &count, sizeof(count));
+}
+
+void EventNotifier::signal() noexcept {
+	const uint64_t one = 1;
+
+	this->signals.store(this->signals.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+	// only fails with EAGAIN once the counter is about to overflow, which still leaves the eventfd readable
+	(void)!write(this->event_fd, &one, sizeof(one));
+}
+/*
+ * End EventNotifier class definitions
+ */
+} // namespace lfmq
@@ -0,0 +1,53 @@
+#include "latency_histogram.hpp"
+
+namespace lfmq
+{
+/*
+ * Start LatencyHistogram class definitions
+ */
+uint64_t LatencyHistogram::value_at_quantile(const double quantile) const noexcept {
+	const uint64_t total = this->count();
+
+	if (total == 0) {
+		return 0;
+	}
+
+	const double clamped = quantile < 0 ? 0 : (quantile > 1 ? 1 : quantile);
+	// rank of the value being looked for, counting from 1
+	uint64_t rank = static_cast<uint64_t>(clamped * static_cast<double>(total));
+	if (rank == 0) {
+		rank = 1;
+	}
+
+	uint64_t seen = 0;
+	for (size_t i = 0; i < BUCKETS; i++) {
+		seen += this->bucket_count(i);
+
+		if (seen >= rank) {
+			return bucket_lower_bound(i);
+		}
+	}
+
+	// counters were being recorded into while they were summed
+	return bucket_lower_bound(BUCKETS - 1);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) noexcept {
+	for (size_t i = 0; i < BUCKETS; i++) {
+		this->counts[i].fetch_add(other.bucket_count(i), std::memory_order_relaxed);
+	}
+
+	this->total.fetch_add(other.count(), std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset() noexcept {
+	for (std::atomic<uint64_t>& count : this->counts) {
+		count.store(0, std::memory_order_relaxed);
+	}
+
+	this->total.store(0, std::memory_order_relaxed);
+}
+/*
+ * End LatencyHistogram class definitions
+ */
+} // namespace lfmq
@@ -0,0 +1,216 @@
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "clock.hpp"
+#include "thread_buffers.hpp"
+
+namespace lfmq
+{
+namespace detail
+{
+std::atomic<uint8_t> log_threshold = LOG_OFF;
+} // namespace detail
+
+namespace
+{
+using LogRegistry = detail::ThreadBufferRegistry<detail::LogRecord, LOG_BUFFER_SIZE>;
+using LogBuffer   = LogRegistry::buffer_type;
+} // namespace
+
+const char* log_level_name(const LogLevel level) noexcept {
+	switch (level) {
+	case LogLevel::VERBOSE: return "verbose";
+	case LogLevel::INFO:    return "info";
+	case LogLevel::WARNING: return "warning";
+	case LogLevel::ERROR:   return "error";
+	}
+
+	return "unknown";
+}
+
+int detail::format_log_line(char* const buffer, const size_t size, const char* const format, ...) {
+	va_list args;
+	va_start(args, format);
+	const int length = vsnprintf(buffer, size, format, args);
+	va_end(args);
+
+	return length;
+}
+
+void detail::record_log_event(const LogLevel level, const char* const format, const LogFormatter formatter, const uint64_t* const args, const size_t count) noexcept {
+	LogRegistry::instance().push_with([&](LogRecord& record) noexcept {
+		record.timestamp = TscClock::now();
+		record.format    = format;
+		record.formatter = formatter;
+		record.level     = level;
+		std::copy_n(args, count, record.args);
+	});
+}
+
+void register_log_thread(const char* const name) {
+	LogRegistry::instance().register_thread(name);
+}
+
+/*
+ * Start LogWriter class definitions
+ */
+struct LogWriter::State {
+	/*
+	 * Formatted line of one drain, sorted by timestamp before it is written
+	 */
+	struct Line {
+		uint64_t    timestamp_ns;
+		std::string text;
+	};
+
+	FILE*                 file = nullptr;
+	detail::DrainThread   drainer;
+	// TscClock reading taken together with a SteadyClock one when the writer started, to convert record timestamps
+	uint64_t              start_ticks = 0;
+	uint64_t              start_ns    = 0;
+	double                ns_per_tick = 1.0;
+	std::atomic<uint64_t> written = 0;
+	std::vector<Line>     lines;
+	// lines of one drain, written with a single fwrite
+	std::string           batch;
+
+	/**
+	 * @brief Convert a TscClock reading into SteadyClock nanoseconds
+	 */
+	uint64_t to_ns(const uint64_t ticks) const noexcept {
+		const double elapsed = static_cast<double>(static_cast<int64_t>(ticks - this->start_ticks)) * this->ns_per_tick;
+		return this->start_ns + static_cast<uint64_t>(static_cast<int64_t>(elapsed));
+	}
+
+	/**
+	 * @brief Append one formatted line to the lines of this drain
+	 */
+	void add_line(const uint64_t timestamp_ns, const LogLevel level, const std::string& thread, const char* const text) {
+		char prefix[64];
+		snprintf(prefix, sizeof(prefix), "%llu.%09llu %-7s ",
+			static_cast<unsigned long long>(timestamp_ns / 1'000'000'000),
+			static_cast<unsigned long long>(timestamp_ns % 1'000'000'000),
+			log_level_name(level));
+
+		this->lines.push_back(Line{ timestamp_ns, std::string(prefix) + '[' + thread + "] " + text + '\n' });
+	}
+
+	/**
+	 * @brief Format and write every buffered record of every thread, forgetting threads that exited
+	 */
+	void drain() {
+		char     text[512];
+		uint64_t count = 0;
+
+		LogRegistry::instance().drain(
+			[&](const LogBuffer&, const std::string& name, const detail::LogRecord& record) {
+				if (record.formatter(text, sizeof(text), record.format, record.args) < 0) {
+					snprintf(text, sizeof(text), "invalid log format: %s", record.format);
+				}
+
+				this->add_line(this->to_ns(record.timestamp), record.level, name, text);
+				count++;
+			},
+			[&](LogBuffer& buffer, const std::string& name, bool) {
+				const uint64_t dropped = buffer.dropped.load(std::memory_order_relaxed);
+
+				if (dropped != buffer.reported) {
+					snprintf(text, sizeof(text), "%llu log records dropped, the log buffer was full", static_cast<unsigned long long>(dropped - buffer.reported));
+					this->add_line(this->to_ns(TscClock::now()), LogLevel::WARNING, name, text);
+					buffer.reported = dropped;
+				}
+			});
+
+		// each thread's lines are in order already, this interleaves the threads
+		std::stable_sort(this->lines.begin(), this->lines.end(), [](const Line& a, const Line& b) {
+			return a.timestamp_ns < b.timestamp_ns;
+		});
+
+		for (const Line& line : this->lines) {
+			this->batch += line.text;
+		}
+		this->lines.clear();
+
+		if (!this->batch.empty()) {
+			fwrite(this->batch.data(), 1, this->batch.size(), this->file);
+			fflush(this->file);
+			this->batch.clear();
+		}
+
+		this->written.fetch_add(count, std::memory_order_relaxed);
+	}
+};
+
+LogWriter::LogWriter() = default;
+
+LogWriter::~LogWriter() {
+	this->stop();
+}
+
+bool LogWriter::start(const char* const path, const LogLevel level, const std::chrono::milliseconds flush_interval) {
+	if (this->state != nullptr) {
+		return false;
+	}
+
+	LogRegistry& registry = LogRegistry::instance();
+
+	if (!registry.claim_writer()) {
+		return false;
+	}
+
+	auto state = std::make_unique<State>();
+	state->file = fopen(path, "a");
+
+	if (state->file == nullptr) {
+		registry.release_writer();
+		return false;
+	}
+
+	// calibrating the counter blocks for a few milliseconds on the first call, so do it here rather than in the first drain
+	state->ns_per_tick = 1e9 / TscClock::ticks_per_second();
+	state->start_ticks = TscClock::now();
+	state->start_ns    = SteadyClock::now();
+
+	this->state = std::move(state);
+	detail::log_threshold.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+	this->state->drainer.start(flush_interval, [state = this->state.get()] { state->drain(); });
+
+	return true;
+}
+
+void LogWriter::stop() {
+	if (this->state == nullptr) {
+		return;
+	}
+
+	detail::log_threshold.store(detail::LOG_OFF, std::memory_order_relaxed);
+
+	this->state->drainer.stop();
+	this->state->drain();
+
+	LogRegistry::instance().release_writer();
+
+	fclose(this->state->file);
+
+	this->last_written = this->state->written.load(std::memory_order_relaxed);
+	this->state.reset();
+}
+
+void LogWriter::set_level(const LogLevel level) noexcept {
+	if (this->state != nullptr) {
+		detail::log_threshold.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+	}
+}
+
+uint64_t LogWriter::records_written() const noexcept {
+	return this->state != nullptr ? this->state->written.load(std::memory_order_relaxed) : this->last_written;
+}
+/*
+ * End LogWriter class definitions
+ */
+} // namespace lfmq
@@ -2,12 +2,42 @@
 
 namespace lfmq
 {
+const char* message_type_name(const MessageType type) noexcept {
+	switch (type) {
+	case MessageType::UNKNOWN:         return "UNKNOWN";
+	case MessageType::RESUME:          return "RESUME";
+	case MessageType::PAUSE:           return "PAUSE";
+	case MessageType::STOP:            return "STOP";
+	case MessageType::VOLUME:          return "VOLUME";
+	case MessageType::RESIZE:          return "RESIZE";
+	case MessageType::EFFECT_ADDED:    return "EFFECT_ADDED";
+	case MessageType::EFFECT_REMOVED:  return "EFFECT_REMOVED";
+	case MessageType::EFFECT_ENABLED:  return "EFFECT_ENABLED";
+	case MessageType::EFFECT_DISABLED: return "EFFECT_DISABLED";
+	case MessageType::PLAY_AT:         return "PLAY_AT";
+	}
+
+	return "UNKNOWN";
+}
+
 /*
  * Start MessageMetadata class definitions
  */
 void MessageMetadata::set_type(const MessageType type) noexcept {
 	this->m_type = type;
 }
+
+void MessageMetadata::set_frame_time(const uint64_t frame_time) noexcept {
+	this->m_frame_time = frame_time;
+}
+
+void MessageMetadata::clear_frame_time() noexcept {
+	this->m_frame_time = NO_FRAME_TIME;
+}
+
+void MessageMetadata::set_correlation_id(const uint32_t correlation_id) noexcept {
+	this->m_correlation_id = correlation_id;
+}
 /*
  * End MessageMetadata class definitions
  */
@@ -0,0 +1,499 @@
+#include "model_checker.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace lfmq::model
+{
+namespace
+{
+using detail::VectorClock;
+
+/// Slot of the thread running the setup and finish of a test
+constexpr size_t SETUP_THREAD = MAX_THREADS;
+
+/*
+ * A point where an execution could go more than one way, and the way the
+ * current execution goes
+ */
+struct Choice {
+	size_t count  = 0;
+	size_t chosen = 0;
+};
+
+std::string thread_name(const size_t thread) {
+	return thread == SETUP_THREAD ? std::string("main thread") : "thread " + std::to_string(thread);
+}
+
+bool is_acquire(const std::memory_order order) noexcept {
+	return order == std::memory_order_consume || order == std::memory_order_acquire
+		|| order == std::memory_order_acq_rel || order == std::memory_order_seq_cst;
+}
+
+bool is_release(const std::memory_order order) noexcept {
+	return order == std::memory_order_release || order == std::memory_order_acq_rel || order == std::memory_order_seq_cst;
+}
+
+void join(VectorClock& clock, const VectorClock& other) noexcept {
+	for (size_t i = 0; i < clock.size(); i++) {
+		clock[i] = std::max(clock[i], other[i]);
+	}
+}
+
+/*
+ * A single run of a test. The threads are real threads, but only the one
+ * holding the baton runs; it hands the baton over at every scheduling point
+ * to the thread picked by the next choice. Choices are replayed from the
+ * prefix left by the previous execution and extended with first options
+ * past its end.
+ */
+class Execution {
+public:
+	Execution(const CheckOptions& options, const size_t threads, std::vector<Choice>& choices) :
+			options(options),
+			threads(threads),
+			choices(choices)
+	{ }
+
+	void run(const std::function<void()>& begin, const std::function<void(size_t)>& body, const std::function<void()>& end);
+
+	/**
+	 * @brief Pick one of count options, replaying the previous execution as long as there is one
+	 * @return Index of the option picked
+	 */
+	size_t choose(const size_t count) {
+		if (count <= 1) {
+			return 0;
+		}
+
+		if (this->next_choice == this->choices.size()) {
+			this->choices.push_back(Choice{ count, 0 });
+		} else if (this->choices[this->next_choice].count != count) {
+			this->fail("the test is not deterministic, a replayed choice changed its number of options");
+			this->choices[this->next_choice] = Choice{ count, 0 };
+			this->choices.resize(this->next_choice + 1);
+		}
+
+		return this->choices[this->next_choice++].chosen;
+	}
+
+	/**
+	 * @brief Let the next choice decide which thread performs the next operation
+	 * @note Called by the running thread before each of its atomic operations
+	 */
+	void schedule() {
+		const size_t self = current_thread;
+
+		if (self == SETUP_THREAD) {
+			return;
+		}
+
+		// continuing with the running thread comes first, every other option is a preemption
+		size_t candidates[MAX_THREADS] = { self };
+		size_t count = 1;
+
+		if (this->preemptions < this->options.preemption_bound) {
+			for (size_t i = 0; i < this->threads; i++) {
+				if (i != self && !this->finished[i]) {
+					candidates[count++] = i;
+				}
+			}
+		}
+
+		const size_t next = candidates[this->choose(count)];
+
+		if (next != self) {
+			this->preemptions++;
+			this->hand_over(self, next);
+		}
+	}
+
+	void fail(const std::string& message) {
+		if (this->failure.empty()) {
+			this->failure = message;
+		}
+	}
+
+	VectorClock& clock() noexcept {
+		return this->clocks[current_thread];
+	}
+
+	const std::string& get_failure() const noexcept {
+		return this->failure;
+	}
+
+	size_t get_choices_made() const noexcept {
+		return this->next_choice;
+	}
+
+	static thread_local Execution* current;
+	static thread_local size_t     current_thread;
+
+private:
+	/**
+	 * @brief Give the baton to next and, unless self finished, wait until it comes back
+	 */
+	void hand_over(const size_t self, const size_t next) {
+		std::unique_lock<std::mutex> lock(this->mutex);
+
+		this->running = next;
+		this->wake.notify_all();
+
+		if (self != next && !this->finished[self]) {
+			this->wake.wait(lock, [&] { return this->running == self; });
+		}
+	}
+
+	void finish_thread(const size_t self) {
+		this->finished[self] = true;
+
+		size_t candidates[MAX_THREADS];
+		size_t count = 0;
+
+		for (size_t i = 0; i < this->threads; i++) {
+			if (!this->finished[i]) {
+				candidates[count++] = i;
+			}
+		}
+
+		if (count == 0) {
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->done = true;
+			this->wake.notify_all();
+			return;
+		}
+
+		this->hand_over(self, candidates[this->choose(count)]);
+	}
+
+	const CheckOptions&  options;
+	const size_t         threads;
+	std::vector<Choice>& choices;
+	size_t               next_choice = 0;
+	size_t               preemptions = 0;
+	std::string          failure;
+
+	std::array<VectorClock, MAX_THREADS + 1> clocks{};
+	std::array<bool, MAX_THREADS>            finished{};
+
+	std::mutex              mutex;
+	std::condition_variable wake;
+	size_t                  running = SETUP_THREAD;
+	bool                    done    = false;
+};
+
+thread_local Execution* Execution::current        = nullptr;
+thread_local size_t     Execution::current_thread = SETUP_THREAD;
+
+void Execution::run(const std::function<void()>& begin, const std::function<void(size_t)>& body, const std::function<void()>& end) {
+	Execution::current        = this;
+	Execution::current_thread = SETUP_THREAD;
+
+	VectorClock& setup_clock = this->clocks[SETUP_THREAD];
+	setup_clock[SETUP_THREAD] = 1;
+
+	begin();
+
+	// every thread starts after the setup
+	std::thread workers[MAX_THREADS];
+	for (size_t i = 0; i < this->threads; i++) {
+		this->clocks[i]    = setup_clock;
+		this->clocks[i][i] = 1;
+
+		workers[i] = std::thread([this, i, &body] {
+			Execution::current        = this;
+			Execution::current_thread = i;
+
+			{
+				std::unique_lock<std::mutex> lock(this->mutex);
+				this->wake.wait(lock, [&] { return this->running == i; });
+			}
+
+			try {
+				body(i);
+			} catch (...) {
+				this->fail(thread_name(i) + " threw an exception");
+			}
+
+			this->finish_thread(i);
+		});
+	}
+	setup_clock[SETUP_THREAD]++;
+
+	{
+		const size_t first = this->choose(this->threads);
+		std::unique_lock<std::mutex> lock(this->mutex);
+		this->running = first;
+		this->wake.notify_all();
+		this->wake.wait(lock, [&] { return this->done; });
+	}
+
+	// and the finish after every thread
+	for (size_t i = 0; i < this->threads; i++) {
+		workers[i].join();
+		join(setup_clock, this->clocks[i]);
+	}
+
+	end();
+
+	Execution::current = nullptr;
+}
+
+bool happens_before(const size_t thread, const uint32_t epoch, const VectorClock& clock) noexcept {
+	return epoch <= clock[thread];
+}
+} // namespace
+
+void check(const bool condition, const char* const message) {
+	if (!condition && Execution::current != nullptr) {
+		Execution::current->fail(thread_name(Execution::current_thread) + ": " + message);
+	}
+}
+
+/*
+ * Start AtomicLocation class definitions
+ */
+detail::AtomicLocation::AtomicLocation(const uint64_t initial) {
+	Execution* const execution = Execution::current;
+
+	if (execution == nullptr) {
+		this->history.push_back(Store{ initial, SETUP_THREAD, 0, {} });
+		return;
+	}
+
+	this->append(initial, std::memory_order_relaxed, nullptr);
+}
+
+uint64_t detail::AtomicLocation::load(const std::memory_order order) {
+	Execution* const execution = Execution::current;
+
+	if (execution == nullptr) {
+		return this->history.back().value;
+	}
+
+	execution->schedule();
+
+	const size_t  thread = Execution::current_thread;
+	VectorClock&  clock  = execution->clock();
+	const size_t  last   = this->history.size() - 1;
+	size_t        index  = last;
+
+	if (order != std::memory_order_seq_cst) {
+		// the oldest store still visible is the latest one the thread either saw or happens after
+		size_t oldest = this->observed[thread];
+		for (size_t i = last; i > oldest; i--) {
+			if (happens_before(this->history[i].thread, this->history[i].epoch, clock)) {
+				oldest = i;
+				break;
+			}
+		}
+
+		index = last - execution->choose(last - oldest + 1);
+	}
+
+	const Store& read = this->history[index];
+	this->observed[thread] = std::max(this->observed[thread], index);
+
+	if (is_acquire(order)) {
+		join(clock, read.release);
+	}
+
+	return read.value;
+}
+
+void detail::AtomicLocation::store(const uint64_t value, const std::memory_order order) {
+	Execution* const execution = Execution::current;
+
+	if (execution == nullptr) {
+		this->history.assign(1, Store{ value, SETUP_THREAD, 0, {} });
+		return;
+	}
+
+	execution->schedule();
+	this->append(value, order, nullptr);
+}
+
+uint64_t detail::AtomicLocation::read_modify_write(const std::memory_order order, uint64_t (* const op)(uint64_t, uint64_t), const uint64_t operand) {
+	Execution* const execution = Execution::current;
+
+	if (execution == nullptr) {
+		const uint64_t previous = this->history.back().value;
+		this->history.back().value = op(previous, operand);
+		return previous;
+	}
+
+	execution->schedule();
+
+	// copied since appending may reallocate the history
+	const Store latest = this->history.back();
+
+	if (is_acquire(order)) {
+		join(execution->clock(), latest.release);
+	}
+
+	// a read-modify-write continues the release sequence of the store it read
+	this->append(op(latest.value, operand), order, &latest.release);
+
+	return latest.value;
+}
+
+bool detail::AtomicLocation::compare_exchange(uint64_t& expected, const uint64_t desired, const std::memory_order success, const std::memory_order failure) {
+	Execution* const execution = Execution::current;
+
+	if (execution == nullptr) {
+		uint64_t& value = this->history.back().value;
+
+		if (value != expected) {
+			expected = value;
+			return false;
+		}
+
+		value = desired;
+		return true;
+	}
+
+	execution->schedule();
+
+	const Store latest = this->history.back();
+
+	if (latest.value != expected) {
+		this->observed[Execution::current_thread] = this->history.size() - 1;
+
+		if (is_acquire(failure)) {
+			join(execution->clock(), latest.release);
+		}
+
+		expected = latest.value;
+		return false;
+	}
+
+	if (is_acquire(success)) {
+		join(execution->clock(), latest.release);
+	}
+
+	this->append(desired, success, &latest.release);
+
+	return true;
+}
+
+void detail::AtomicLocation::append(const uint64_t value, const std::memory_order order, const VectorClock* const inherited) {
+	const size_t thread = Execution::current_thread;
+	VectorClock& clock  = Execution::current->clock();
+
+	Store store;
+	store.value  = value;
+	store.thread = thread;
+	store.epoch  = clock[thread];
+
+	if (is_release(order)) {
+		store.release = clock;
+	}
+
+	if (inherited != nullptr) {
+		join(store.release, *inherited);
+	}
+
+	this->history.push_back(store);
+	this->observed[thread] = this->history.size() - 1;
+
+	// so that later operations of the thread do not appear to happen before this store's readers
+	clock[thread]++;
+}
+/*
+ * End AtomicLocation class definitions
+ */
+
+/*
+ * Start DataLocation class definitions
+ */
+detail::DataLocation::DataLocation() {
+	if (Execution::current != nullptr) {
+		this->writer      = Execution::current_thread;
+		this->write_epoch = Execution::current->clock()[this->writer];
+	}
+}
+
+void detail::DataLocation::on_read() {
+	Execution* const execution = Execution::current;
+
+	if (execution == nullptr) {
+		return;
+	}
+
+	const size_t       thread = Execution::current_thread;
+	const VectorClock& clock  = execution->clock();
+
+	if (!happens_before(this->writer, this->write_epoch, clock)) {
+		execution->fail("data race: " + thread_name(thread) + " read a Var written by " + thread_name(this->writer) + " without synchronizing with the write");
+	}
+
+	this->read_epochs[thread] = clock[thread];
+}
+
+void detail::DataLocation::on_write() {
+	Execution* const execution = Execution::current;
+
+	if (execution == nullptr) {
+		return;
+	}
+
+	const size_t       thread = Execution::current_thread;
+	const VectorClock& clock  = execution->clock();
+
+	if (!happens_before(this->writer, this->write_epoch, clock)) {
+		execution->fail("data race: " + thread_name(thread) + " wrote a Var written by " + thread_name(this->writer) + " without synchronizing with the write");
+	}
+
+	for (size_t i = 0; i < this->read_epochs.size(); i++) {
+		if (this->read_epochs[i] != 0 && !happens_before(i, this->read_epochs[i], clock)) {
+			execution->fail("data race: " + thread_name(thread) + " wrote a Var read by " + thread_name(i) + " without synchronizing with the read");
+		}
+	}
+
+	this->writer      = thread;
+	this->write_epoch = clock[thread];
+	this->read_epochs.fill(0);
+}
+/*
+ * End DataLocation class definitions
+ */
+
+CheckReport detail::explore(const CheckOptions& options, const size_t threads, const std::function<void()>& begin, const std::function<void(size_t)>& run, const std::function<void()>& end) {
+	CheckReport report;
+
+	if (threads == 0 || threads > MAX_THREADS) {
+		report.failure = "a test needs between 1 and " + std::to_string(MAX_THREADS) + " threads";
+		return report;
+	}
+
+	std::vector<Choice> choices;
+
+	while (report.executions < options.max_executions) {
+		Execution execution(options, threads, choices);
+		execution.run(begin, run, end);
+		report.executions++;
+
+		if (!execution.get_failure().empty()) {
+			report.failure = "execution " + std::to_string(report.executions) + ": " + execution.get_failure();
+			return report;
+		}
+
+		// depth first: move to the next option of the deepest choice that has one left
+		choices.resize(execution.get_choices_made());
+		while (!choices.empty() && choices.back().chosen + 1 == choices.back().count) {
+			choices.pop_back();
+		}
+
+		if (choices.empty()) {
+			report.exhausted = true;
+			break;
+		}
+
+		choices.back().chosen++;
+	}
+
+	return report;
+}
+} // namespace lfmq::model
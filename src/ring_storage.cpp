@@ -0,0 +1,148 @@
+#include "ring_storage.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "cache_line.hpp"
+
+namespace lfmq
+{
+namespace
+{
+#if defined(__linux__)
+/// Huge page size assumed when /proc/meminfo does not say
+constexpr size_t DEFAULT_HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+size_t round_up(const size_t value, const size_t multiple) noexcept {
+	return (value + multiple - 1) / multiple * multiple;
+}
+
+/**
+ * @brief Return the default huge page size from /proc/meminfo
+ */
+size_t huge_page_size() {
+	static const size_t size = [] {
+		FILE* const file = fopen("/proc/meminfo", "r");
+		size_t      kib  = 0;
+
+		if (file != nullptr) {
+			char line[128];
+
+			while (fgets(line, sizeof(line), file) != nullptr) {
+				if (sscanf(line, "Hugepagesize: %zu kB", &kib) == 1) {
+					break;
+				}
+			}
+
+			fclose(file);
+		}
+
+		return kib != 0 ? kib * 1024 : DEFAULT_HUGE_PAGE_SIZE;
+	}();
+
+	return size;
+}
+
+/**
+ * @brief Map length bytes starting at a multiple of alignment, by mapping more and unmapping what sticks out
+ * @return Start of the mapping, MAP_FAILED if it could not be mapped
+ */
+void* map_aligned(const size_t length, const size_t alignment) noexcept {
+	void* const mapping = mmap(nullptr, length + alignment, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (mapping == MAP_FAILED) {
+		return MAP_FAILED;
+	}
+
+	const uintptr_t start   = reinterpret_cast<uintptr_t>(mapping);
+	const uintptr_t aligned = round_up(start, alignment);
+
+	if (aligned != start) {
+		munmap(mapping, aligned - start);
+	}
+	munmap(reinterpret_cast<void*>(aligned + length), start + alignment - aligned);
+
+	return reinterpret_cast<void*>(aligned);
+}
+#endif
+} // namespace
+
+const char* ring_pages_name(const RingPages pages) noexcept {
+	switch (pages) {
+	case RingPages::HUGETLB:          return "hugetlb";
+	case RingPages::TRANSPARENT_HUGE: return "transparent_huge";
+	case RingPages::REGULAR:          return "regular";
+	}
+
+	return "unknown";
+}
+
+detail::MappedRing detail::map_ring(const size_t bytes) {
+	MappedRing ring;
+
+#if defined(__linux__)
+	const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const size_t huge = huge_page_size();
+
+	ring.address = MAP_FAILED;
+	ring.length  = round_up(bytes, huge);
+
+	// a ring smaller than a huge page would take a whole page out of the reserved pool, or be split by THP anyway
+	if (bytes >= huge) {
+		// fails right away unless the administrator reserved a pool that still has room
+		ring.address = mmap(nullptr, ring.length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		ring.pages   = RingPages::HUGETLB;
+	}
+
+	if (ring.address == MAP_FAILED && bytes >= huge) {
+		ring.address = map_aligned(ring.length, huge);
+		ring.pages   = RingPages::TRANSPARENT_HUGE;
+
+		if (ring.address != MAP_FAILED && madvise(ring.address, ring.length, MADV_HUGEPAGE) != 0) {
+			ring.pages = RingPages::REGULAR;
+		}
+	}
+
+	if (ring.address == MAP_FAILED) {
+		ring.length  = round_up(bytes, page);
+		ring.address = mmap(nullptr, ring.length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		ring.pages   = RingPages::REGULAR;
+	}
+
+	if (ring.address == MAP_FAILED) {
+		throw std::bad_alloc();
+	}
+
+	// write every page so that it is backed now rather than on the first lap of the real-time thread
+	volatile char* const memory = static_cast<char*>(ring.address);
+	for (size_t offset = 0; offset < ring.length; offset += page) {
+		memory[offset] = 0;
+	}
+
+	ring.locked = mlock(ring.address, ring.length) == 0;
+#else
+	ring.length  = bytes;
+	ring.address = ::operator new(bytes, std::align_val_t{ CACHE_LINE_SIZE });
+	ring.pages   = RingPages::REGULAR;
+	std::memset(ring.address, 0, bytes);
+#endif
+
+	return ring;
+}
+
+void detail::unmap_ring(const MappedRing& ring) noexcept {
+#if defined(__linux__)
+	// also unlocks the range
+	munmap(ring.address, ring.length);
+#else
+	::operator delete(ring.address, std::align_val_t{ CACHE_LINE_SIZE });
+#endif
+}
+} // namespace lfmq
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+#include "lock_free_queue.hpp"
+
+namespace lfmq::detail
+{
+/*
+ * Per-thread record buffers drained by a single writer thread, shared by the
+ * tracer and the logger. Each thread pushes its records onto a ring of its
+ * own, so recording is wait-free and never touches a lock. The registry is
+ * only locked when a thread registers and by the writer.
+ */
+
+inline uint64_t current_thread_id() noexcept {
+#if defined(__linux__)
+	return static_cast<uint64_t>(syscall(SYS_gettid));
+#else
+	return static_cast<uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+#endif
+}
+
+/*
+ * Buffer of a single thread. The thread is the producer and the writer is
+ * the consumer.
+ */
+template <typename _Record, size_t _size>
+struct ThreadBuffer {
+	SpscQueue<_Record, _size> records;
+
+	std::atomic<uint64_t> dropped  = 0;
+	std::atomic<bool>     exited   = false;
+	uint64_t              reported = 0; // Dropped records the writer already reported, only touched by the writer
+	uint64_t              tid      = 0;
+	std::string           name;
+};
+
+/*
+ * Every buffer of one kind of record ever registered. A thread's buffer is
+ * owned by a thread_local handle as well, which marks the buffer as exited
+ * when the thread exits so that the writer can forget it once drained.
+ */
+template <typename _Record, size_t _size>
+class ThreadBufferRegistry {
+public:
+	using buffer_type = ThreadBuffer<_Record, _size>;
+	using buffer_ptr  = std::shared_ptr<buffer_type>;
+
+	static ThreadBufferRegistry& instance() {
+		static ThreadBufferRegistry registry;
+		return registry;
+	}
+
+	/**
+	 * @brief Allocate the buffer of the calling thread if it has none and optionally rename the thread
+	 * @param name Name of the thread, nullptr to keep the current one. Copied
+	 */
+	void register_thread(const char* const name) {
+		if (this_thread.buffer == nullptr) {
+			auto buffer  = std::make_shared<buffer_type>();
+			buffer->tid  = current_thread_id();
+			buffer->name = "thread " + std::to_string(buffer->tid);
+
+			std::lock_guard<std::mutex> lock(this->mutex);
+
+			// without a writer nobody else forgets the buffers of threads that exited
+			if (!this->writer_running) {
+				std::erase_if(this->buffers, [](const buffer_ptr& other) {
+					return other->exited.load(std::memory_order_acquire) && other->records.is_empty();
+				});
+			}
+
+			this->buffers.push_back(buffer);
+
+			this_thread.buffer = std::move(buffer);
+		}
+
+		if (name != nullptr) {
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this_thread.buffer->name = name;
+		}
+	}
+
+	/**
+	 * @brief Push a record onto the buffer of the calling thread, registering the thread first if needed
+	 * @note Wait-free once the thread is registered
+	 */
+	void push(const _Record& record) noexcept {
+		this->push_with([&](_Record& slot) noexcept {
+			slot = record;
+		});
+	}
+
+	/**
+	 * @brief Fill a record directly in its slot of the buffer of the calling thread, registering the thread first if needed
+	 * @note Wait-free once the thread is registered
+	 * @param fill Called as fill(slot), must set every field of the record and must not throw
+	 */
+	template <typename _Fill>
+	void push_with(_Fill&& fill) noexcept {
+		buffer_type* buffer = this_thread.buffer.get();
+
+		if (buffer == nullptr) {
+			try {
+				this->register_thread(nullptr);
+			} catch (...) {
+				return;
+			}
+
+			buffer = this_thread.buffer.get();
+		}
+
+		if (!buffer->records.push_with(std::forward<_Fill>(fill))) {
+			buffer->dropped.store(buffer->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * @brief Become the only writer draining the buffers
+	 * @return False if another writer is running
+	 */
+	bool claim_writer() {
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		if (this->writer_running) {
+			return false;
+		}
+
+		this->writer_running = true;
+		return true;
+	}
+
+	void release_writer() {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->writer_running = false;
+	}
+
+	/**
+	 * @brief Pop every buffered record of every thread, forgetting threads that exited once drained
+	 * @param on_record Called as on_record(buffer, name, record) for each record
+	 * @param on_drained Called as on_drained(buffer, name, exited) after each buffer was drained
+	 */
+	template <typename _OnRecord, typename _OnDrained>
+	void drain(_OnRecord&& on_record, _OnDrained&& on_drained) {
+		std::vector<std::string> names;
+		const std::vector<buffer_ptr> drained = this->snapshot(names);
+
+		_Record record;
+
+		for (size_t i = 0; i < drained.size(); i++) {
+			buffer_type& buffer = *drained[i];
+
+			// read before draining so that every record of an exited thread is drained before it is forgotten
+			const bool exited = buffer.exited.load(std::memory_order_acquire);
+
+			while (buffer.records.pop(&record)) {
+				on_record(buffer, names[i], record);
+			}
+
+			on_drained(buffer, names[i], exited);
+
+			if (exited) {
+				std::lock_guard<std::mutex> lock(this->mutex);
+				std::erase(this->buffers, drained[i]);
+			}
+		}
+	}
+
+	/**
+	 * @brief Return every registered buffer and the current name of its thread
+	 * @param names Filled with the name of the thread of each buffer
+	 */
+	std::vector<buffer_ptr> snapshot(std::vector<std::string>& names) {
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		names.clear();
+		for (const buffer_ptr& buffer : this->buffers) {
+			names.push_back(buffer->name);
+		}
+
+		return this->buffers;
+	}
+
+private:
+	/*
+	 * Marks the buffer of the thread as exited when the thread exits
+	 */
+	struct Handle {
+		buffer_ptr buffer;
+
+		~Handle() {
+			if (this->buffer != nullptr) {
+				this->buffer->exited.store(true, std::memory_order_release);
+			}
+		}
+	};
+
+	static inline thread_local Handle this_thread;
+
+	std::mutex              mutex;
+	std::vector<buffer_ptr> buffers;
+	bool                    writer_running = false;
+};
+
+/*
+ * Background thread that calls a drain function every flush interval until
+ * stopped. The final drain after stop is left to the owner, which usually
+ * writes a trailer right after it.
+ */
+class DrainThread {
+public:
+	DrainThread() = default;
+	DrainThread(const DrainThread&) = delete;
+	DrainThread& operator=(const DrainThread&) = delete;
+
+	~DrainThread() {
+		this->stop();
+	}
+
+	/**
+	 * @param flush_interval How often drain is called
+	 * @param drain Called on the drain thread
+	 */
+	void start(const std::chrono::milliseconds flush_interval, std::function<void()> drain) {
+		this->stopping = false;
+		this->thread   = std::thread([this, flush_interval, drain = std::move(drain)] {
+			std::unique_lock<std::mutex> lock(this->mutex);
+			while (!this->stopping) {
+				this->wake.wait_for(lock, flush_interval);
+
+				lock.unlock();
+				drain();
+				lock.lock();
+			}
+		});
+	}
+
+	/**
+	 * @brief Wake the thread and wait for it to exit
+	 */
+	void stop() {
+		if (!this->thread.joinable()) {
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->stopping = true;
+		}
+		this->wake.notify_one();
+		this->thread.join();
+	}
+
+private:
+	std::thread             thread;
+	std::mutex              mutex;
+	std::condition_variable wake;
+	bool                    stopping = false;
+};
+} // namespace lfmq::detail
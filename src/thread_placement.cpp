@@ -0,0 +1,244 @@
+#include "thread_placement.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace lfmq
+{
+namespace
+{
+constexpr const char* SYSFS_CPU = "/sys/devices/system/cpu/cpu";
+
+/**
+ * @brief Read the first line of a sysfs file
+ * @return Whether the file could be read
+ */
+bool read_line(const std::string& path, std::string& line) {
+	FILE* const file = fopen(path.c_str(), "r");
+
+	if (file == nullptr) {
+		return false;
+	}
+
+	char buffer[256];
+	const bool read = fgets(buffer, sizeof(buffer), file) != nullptr;
+	fclose(file);
+
+	if (read) {
+		line = buffer;
+	}
+
+	return read;
+}
+
+/**
+ * @brief Read a sysfs file holding a single integer
+ * @return Value in the file, -1 if it could not be read
+ */
+int read_int(const std::string& path) {
+	std::string line;
+
+	return read_line(path, line) ? atoi(line.c_str()) : -1;
+}
+
+/**
+ * @brief Read a sysfs CPU list such as "0-3,8-11" and return the lowest CPU in it, which names the group
+ * @return Lowest CPU in the list, -1 if it could not be read
+ */
+int read_group(const std::string& path) {
+	std::string line;
+
+	if (!read_line(path, line) || line.empty() || line[0] < '0' || line[0] > '9') {
+		return -1;
+	}
+
+	return atoi(line.c_str());
+}
+} // namespace
+
+const char* cpu_distance_name(const CpuDistance distance) noexcept {
+	switch (distance) {
+	case CpuDistance::SAME_CPU:      return "same_cpu";
+	case CpuDistance::SMT_SIBLING:   return "smt_sibling";
+	case CpuDistance::SHARED_L2:     return "shared_l2";
+	case CpuDistance::SHARED_L3:     return "shared_l3";
+	case CpuDistance::SAME_PACKAGE:  return "same_package";
+	case CpuDistance::CROSS_PACKAGE: return "cross_package";
+	}
+
+	return "unknown";
+}
+
+/*
+ * Start CpuTopology class definitions
+ */
+CpuTopology CpuTopology::read() {
+	CpuTopology topology;
+
+	for (const int cpu : allowed_cpus()) {
+		const std::string base = SYSFS_CPU + std::to_string(cpu);
+
+		Cpu entry;
+		entry.cpu     = cpu;
+		entry.package = read_int(base + "/topology/physical_package_id");
+		entry.core    = read_group(base + "/topology/thread_siblings_list");
+
+		// index0 and index1 are usually the L1 data and instruction caches, so look at the level of each one
+		for (int index = 0;; index++) {
+			const std::string cache = base + "/cache/index" + std::to_string(index);
+			const int         level = read_int(cache + "/level");
+
+			if (level < 0) {
+				break;
+			}
+
+			std::string type;
+			if (!read_line(cache + "/type", type) || type.compare(0, 11, "Instruction") == 0) {
+				continue;
+			}
+
+			if (level == 2) {
+				entry.l2 = read_group(cache + "/shared_cpu_list");
+			} else if (level == 3) {
+				entry.l3 = read_group(cache + "/shared_cpu_list");
+			}
+		}
+
+		topology.entries.push_back(entry);
+	}
+
+	return topology;
+}
+
+CpuDistance CpuTopology::distance(const int a, const int b) const noexcept {
+	const Cpu* const first  = this->find(a);
+	const Cpu* const second = this->find(b);
+
+	if (first == nullptr || second == nullptr) {
+		return CpuDistance::CROSS_PACKAGE;
+	}
+
+	const auto shared = [](const int x, const int y) {
+		return x >= 0 && x == y;
+	};
+
+	if (a == b) {
+		return CpuDistance::SAME_CPU;
+	}
+	if (shared(first->core, second->core)) {
+		return CpuDistance::SMT_SIBLING;
+	}
+	if (shared(first->l2, second->l2)) {
+		return CpuDistance::SHARED_L2;
+	}
+	if (shared(first->l3, second->l3)) {
+		return CpuDistance::SHARED_L3;
+	}
+	if (shared(first->package, second->package)) {
+		return CpuDistance::SAME_PACKAGE;
+	}
+
+	return CpuDistance::CROSS_PACKAGE;
+}
+
+CpuDistance CpuTopology::closest_pair(int& first, int& second) const noexcept {
+	first  = this->entries.empty() ? 0 : this->entries.front().cpu;
+	second = first;
+
+	CpuDistance best  = CpuDistance::SAME_CPU;
+	bool        found = false;
+
+	// ranks sibling hyperthreads behind every pair of separate cores, since they compete for one core's execution units
+	const auto rank = [](const CpuDistance distance) {
+		return distance == CpuDistance::SMT_SIBLING ? static_cast<int>(CpuDistance::CROSS_PACKAGE) + 1 : static_cast<int>(distance);
+	};
+
+	for (size_t i = 0; i < this->entries.size(); i++) {
+		for (size_t j = i + 1; j < this->entries.size(); j++) {
+			const CpuDistance distance = this->distance(this->entries[i].cpu, this->entries[j].cpu);
+
+			if (!found || rank(distance) < rank(best)) {
+				first  = this->entries[i].cpu;
+				second = this->entries[j].cpu;
+				best   = distance;
+				found  = true;
+			}
+		}
+	}
+
+	return best;
+}
+
+const CpuTopology::Cpu* CpuTopology::find(const int cpu) const noexcept {
+	const auto it = std::lower_bound(this->entries.begin(), this->entries.end(), cpu, [](const Cpu& entry, const int cpu) {
+		return entry.cpu < cpu;
+	});
+
+	return it != this->entries.end() && it->cpu == cpu ? &*it : nullptr;
+}
+/*
+ * End CpuTopology class definitions
+ */
+
+std::vector<int> allowed_cpus() {
+	std::vector<int> cpus;
+
+#if defined(__linux__)
+	cpu_set_t set;
+
+	if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+		for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+			if (CPU_ISSET(cpu, &set)) {
+				cpus.push_back(cpu);
+			}
+		}
+	}
+#endif
+
+	if (cpus.empty()) {
+		cpus.push_back(0);
+	}
+
+	return cpus;
+}
+
+bool pin_this_thread(const int cpu) {
+	if (cpu < 0) {
+		return true;
+	}
+
+#if defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+	return false;
+#endif
+}
+
+bool set_realtime_priority(const int priority) {
+#if defined(__linux__)
+	sched_param param{};
+
+	if (priority <= 0) {
+		return pthread_setschedparam(pthread_self(), SCHED_OTHER, &param) == 0;
+	}
+
+	param.sched_priority = std::clamp(priority, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+
+	return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#else
+	(void)priority;
+	return false;
+#endif
+}
+} // namespace lfmq
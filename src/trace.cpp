@@ -0,0 +1,215 @@
+#include "trace.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "clock.hpp"
+#include "thread_buffers.hpp"
+
+namespace lfmq
+{
+namespace detail
+{
+std::atomic<bool> trace_enabled = false;
+} // namespace detail
+
+namespace
+{
+struct TraceRecord {
+	uint64_t       timestamp_ns = 0;
+	uint32_t       queue_id     = 0;
+	int16_t        message_type = NO_MESSAGE_TYPE;
+	TraceEventKind kind         = TraceEventKind::PUSH;
+};
+
+using TraceRegistry = detail::ThreadBufferRegistry<TraceRecord, TRACE_BUFFER_SIZE>;
+using TraceBuffer   = TraceRegistry::buffer_type;
+
+const char* kind_name(const TraceEventKind kind) noexcept {
+	switch (kind) {
+	case TraceEventKind::PUSH:        return "push";
+	case TraceEventKind::PUSH_FAILED: return "push_failed";
+	case TraceEventKind::POP:         return "pop";
+	case TraceEventKind::DISPATCH:    return "dispatch";
+	}
+
+	return "unknown";
+}
+
+/**
+ * @brief Escape a string for use inside a JSON string literal
+ * @return Escaped string, without the surrounding quotes
+ */
+std::string json_escape(const std::string& text) {
+	std::string escaped;
+	escaped.reserve(text.size());
+
+	for (const char c : text) {
+		switch (c) {
+		case '"':  escaped += "\\\""; break;
+		case '\\': escaped += "\\\\"; break;
+		case '\n': escaped += "\\n"; break;
+		case '\r': escaped += "\\r"; break;
+		case '\t': escaped += "\\t"; break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20) {
+				char code[8];
+				snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned>(c));
+				escaped += code;
+			} else {
+				escaped += c;
+			}
+		}
+	}
+
+	return escaped;
+}
+} // namespace
+
+void detail::record_trace_event(const TraceEventKind kind, const uint32_t queue_id, const int16_t message_type) noexcept {
+	TraceRecord record;
+	record.timestamp_ns = SteadyClock::now();
+	record.queue_id     = queue_id;
+	record.message_type = message_type;
+	record.kind         = kind;
+
+	TraceRegistry::instance().push(record);
+}
+
+void register_trace_thread(const char* const name) {
+	TraceRegistry::instance().register_thread(name);
+}
+
+/*
+ * Start TraceWriter class definitions
+ */
+struct TraceWriter::State {
+	FILE*                 file = nullptr;
+	detail::DrainThread   drainer;
+	std::atomic<uint64_t> written = 0;
+	bool                  first   = true;
+	long                  pid     = 0;
+
+	void write_event(const char* const json) {
+		fprintf(this->file, "%s\n%s", this->first ? "" : ",", json);
+		this->first = false;
+		this->written.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/**
+	 * @brief Write every buffered event of every thread, and the metadata of threads that exited
+	 */
+	void drain() {
+		char json[256];
+
+		TraceRegistry::instance().drain(
+			[&](const TraceBuffer& buffer, const std::string&, const TraceRecord& record) {
+				const char* const type = record.message_type == NO_MESSAGE_TYPE ? "" : message_type_name(static_cast<MessageType>(record.message_type));
+
+				snprintf(json, sizeof(json),
+					"{\"name\":\"%s\",\"cat\":\"lfmq\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%ld,\"tid\":%llu,\"args\":{\"queue\":%u,\"type\":\"%s\"}}",
+					kind_name(record.kind),
+					static_cast<double>(record.timestamp_ns) / 1000.0,
+					this->pid,
+					static_cast<unsigned long long>(buffer.tid),
+					record.queue_id,
+					type);
+				this->write_event(json);
+			},
+			[&](const TraceBuffer& buffer, const std::string& name, const bool exited) {
+				if (exited) {
+					this->write_metadata(buffer, name);
+				}
+			});
+
+		fflush(this->file);
+	}
+
+	void write_metadata(const TraceBuffer& buffer, const std::string& name) {
+		std::string json = "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + std::to_string(this->pid)
+			+ ",\"tid\":" + std::to_string(buffer.tid)
+			+ ",\"args\":{\"name\":\"" + json_escape(name) + "\"}}";
+		this->write_event(json.c_str());
+
+		const uint64_t dropped = buffer.dropped.load(std::memory_order_relaxed);
+		if (dropped > 0) {
+			json = "{\"name\":\"dropped_events\",\"cat\":\"lfmq\",\"ph\":\"i\",\"s\":\"t\",\"ts\":0,\"pid\":" + std::to_string(this->pid)
+				+ ",\"tid\":" + std::to_string(buffer.tid)
+				+ ",\"args\":{\"count\":" + std::to_string(dropped) + "}}";
+			this->write_event(json.c_str());
+		}
+	}
+};
+
+TraceWriter::TraceWriter() = default;
+
+TraceWriter::~TraceWriter() {
+	this->stop();
+}
+
+bool TraceWriter::start(const char* const path, const std::chrono::milliseconds flush_interval) {
+	if (this->state != nullptr) {
+		return false;
+	}
+
+	TraceRegistry& registry = TraceRegistry::instance();
+
+	if (!registry.claim_writer()) {
+		return false;
+	}
+
+	auto state = std::make_unique<State>();
+	state->file = fopen(path, "w");
+
+	if (state->file == nullptr) {
+		registry.release_writer();
+		return false;
+	}
+
+	state->pid = static_cast<long>(getpid());
+	fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", state->file);
+
+	this->state = std::move(state);
+	detail::trace_enabled.store(true, std::memory_order_relaxed);
+	this->state->drainer.start(flush_interval, [state = this->state.get()] { state->drain(); });
+
+	return true;
+}
+
+void TraceWriter::stop() {
+	if (this->state == nullptr) {
+		return;
+	}
+
+	detail::trace_enabled.store(false, std::memory_order_relaxed);
+
+	this->state->drainer.stop();
+	this->state->drain();
+
+	TraceRegistry& registry = TraceRegistry::instance();
+	registry.release_writer();
+
+	// threads that are still alive keep their buffer for the next writer
+	std::vector<std::string> names;
+	const auto buffers = registry.snapshot(names);
+	for (size_t i = 0; i < buffers.size(); i++) {
+		this->state->write_metadata(*buffers[i], names[i]);
+	}
+
+	fputs("\n]}\n", this->state->file);
+	fclose(this->state->file);
+
+	this->last_written = this->state->written.load(std::memory_order_relaxed);
+	this->state.reset();
+}
+
+uint64_t TraceWriter::events_written() const noexcept {
+	return this->state != nullptr ? this->state->written.load(std::memory_order_relaxed) : this->last_written;
+}
+/*
+ * End TraceWriter class definitions
+ */
+} // namespace lfmq
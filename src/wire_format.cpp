@@ -0,0 +1,161 @@
+#include "wire_format.hpp"
+
+namespace lfmq
+{
+namespace
+{
+void store_u16(std::byte* const dst, const uint16_t value) noexcept {
+	dst[0] = static_cast<std::byte>(value);
+	dst[1] = static_cast<std::byte>(value >> 8);
+}
+
+void store_u32(std::byte* const dst, const uint32_t value) noexcept {
+	for (size_t i = 0; i < sizeof(value); i++) {
+		dst[i] = static_cast<std::byte>(value >> (8 * i));
+	}
+}
+
+void store_u64(std::byte* const dst, const uint64_t value) noexcept {
+	for (size_t i = 0; i < sizeof(value); i++) {
+		dst[i] = static_cast<std::byte>(value >> (8 * i));
+	}
+}
+
+uint16_t load_u16(const std::byte* const src) noexcept {
+	return static_cast<uint16_t>(static_cast<uint16_t>(src[0]) | (static_cast<uint16_t>(src[1]) << 8));
+}
+
+uint32_t load_u32(const std::byte* const src) noexcept {
+	uint32_t value = 0;
+
+	for (size_t i = 0; i < sizeof(value); i++) {
+		value |= static_cast<uint32_t>(src[i]) << (8 * i);
+	}
+
+	return value;
+}
+
+uint64_t load_u64(const std::byte* const src) noexcept {
+	uint64_t value = 0;
+
+	for (size_t i = 0; i < sizeof(value); i++) {
+		value |= static_cast<uint64_t>(src[i]) << (8 * i);
+	}
+
+	return value;
+}
+
+constexpr uint8_t KNOWN_FLAGS = WIRE_FLAG_FRAME_TIME | WIRE_FLAG_CORRELATION_ID;
+
+constexpr bool has_correlation_id(const MessageMetadata& metadata) noexcept {
+	return metadata.get_correlation_id() != MessageMetadata::NO_CORRELATION_ID;
+}
+} // namespace
+
+size_t wire_size(const Message& message) noexcept {
+	size_t size = WIRE_HEADER_SIZE + message.get_payload_size();
+
+	if (message.get_metadata().has_frame_time()) {
+		size += sizeof(uint64_t);
+	}
+
+	if (has_correlation_id(message.get_metadata())) {
+		size += sizeof(uint32_t);
+	}
+
+	return size;
+}
+
+size_t encode_message(const Message& message, const std::span<std::byte> buffer) noexcept {
+	const size_t size = wire_size(message);
+
+	if (buffer.size() < size) {
+		return 0;
+	}
+
+	const MessageMetadata& metadata = message.get_metadata();
+	uint8_t                flags    = 0;
+
+	if (metadata.has_frame_time()) {
+		flags |= WIRE_FLAG_FRAME_TIME;
+	}
+
+	if (has_correlation_id(metadata)) {
+		flags |= WIRE_FLAG_CORRELATION_ID;
+	}
+
+	std::byte* dst = buffer.data();
+
+	dst[0] = static_cast<std::byte>(WIRE_FORMAT_VERSION);
+	dst[1] = static_cast<std::byte>(flags);
+	store_u16(dst + 2, static_cast<uint16_t>(metadata.get_type()));
+	store_u32(dst + 4, static_cast<uint32_t>(message.get_payload_size()));
+	dst += WIRE_HEADER_SIZE;
+
+	if (metadata.has_frame_time()) {
+		store_u64(dst, metadata.get_frame_time());
+		dst += sizeof(uint64_t);
+	}
+
+	if (has_correlation_id(metadata)) {
+		store_u32(dst, metadata.get_correlation_id());
+		dst += sizeof(uint32_t);
+	}
+
+	memcpy(dst, message.get_payload(), message.get_payload_size());
+
+	return size;
+}
+
+DecodeResult decode_message(const std::span<const std::byte> buffer, MessageView& view) noexcept {
+	if (buffer.size() < WIRE_HEADER_SIZE) {
+		return { WireStatus::TRUNCATED, 0 };
+	}
+
+	const std::byte* src = buffer.data();
+
+	if (static_cast<uint8_t>(src[0]) != WIRE_FORMAT_VERSION) {
+		return { WireStatus::UNSUPPORTED_VERSION, 0 };
+	}
+
+	const uint8_t  flags        = static_cast<uint8_t>(src[1]);
+	const uint16_t type         = load_u16(src + 2);
+	const uint32_t payload_size = load_u32(src + 4);
+
+	if ((flags & ~KNOWN_FLAGS) != 0
+			|| type > static_cast<uint16_t>(MessageType::PLAY_AT)
+			|| payload_size > Message::MAX_MESSAGE_SIZE) {
+		return { WireStatus::MALFORMED, 0 };
+	}
+
+	size_t size = WIRE_HEADER_SIZE + payload_size;
+	if ((flags & WIRE_FLAG_FRAME_TIME) != 0) {
+		size += sizeof(uint64_t);
+	}
+
+	if ((flags & WIRE_FLAG_CORRELATION_ID) != 0) {
+		size += sizeof(uint32_t);
+	}
+
+	if (buffer.size() < size) {
+		return { WireStatus::TRUNCATED, 0 };
+	}
+
+	MessageMetadata metadata(static_cast<MessageType>(type));
+	src += WIRE_HEADER_SIZE;
+
+	if ((flags & WIRE_FLAG_FRAME_TIME) != 0) {
+		metadata.set_frame_time(load_u64(src));
+		src += sizeof(uint64_t);
+	}
+
+	if ((flags & WIRE_FLAG_CORRELATION_ID) != 0) {
+		metadata.set_correlation_id(load_u32(src));
+		src += sizeof(uint32_t);
+	}
+
+	view = MessageView(metadata, std::span<const std::byte>(src, payload_size));
+
+	return { WireStatus::OK, size };
+}
+} // namespace lfmq